@@ -14,6 +14,7 @@
 #include "gfx/sfml_canvas.h"
 #include "img/jpeg_turbo.h"
 #include "img/png.h"
+#include "layout/box_index.h"
 #include "layout/layout.h"
 #include "layout/layout_box.h"
 #include "os/system_info.h"
@@ -346,7 +347,7 @@ void App::step() {
         handle_event(*event);
     }
 
-    bool should_relayout{};
+    std::vector<std::string> loaded_resources;
     for (auto it = begin(ongoing_loads_); it != end(ongoing_loads_);) {
         auto &load = *it;
         if (load.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
@@ -373,13 +374,13 @@ void App::step() {
                 continue;
             }
 
-            auto &image = images_[std::move(result.resource_id)];
+            auto &image = images_[result.resource_id];
             image.width = png->width;
             image.height = png->height;
             image.rgba_bytes = std::move(png->bytes);
             spdlog::info(
                     "Parsed image (w={},h={}) '{}'", image.width, image.height, result.result.uri_after_redirects.uri);
-            should_relayout = true;
+            loaded_resources.push_back(std::move(result.resource_id));
         } else {
             assert(result.resource_id.ends_with(".jpg") || result.resource_id.ends_with(".jpeg"));
             auto const &body = result.result.response->body;
@@ -389,13 +390,13 @@ void App::step() {
                 continue;
             }
 
-            auto &image = images_[std::move(result.resource_id)];
+            auto &image = images_[result.resource_id];
             image.width = jpeg->width;
             image.height = jpeg->height;
             image.rgba_bytes = std::move(jpeg->bytes);
             spdlog::info(
                     "Parsed image (w={},h={}) '{}'", image.width, image.height, result.result.uri_after_redirects.uri);
-            should_relayout = true;
+            loaded_resources.push_back(std::move(result.resource_id));
         }
     }
 
@@ -405,9 +406,9 @@ void App::step() {
         ongoing_loads_.push_back(load_image(*engine_, std::move(uri), std::move(id)));
     }
 
-    if (should_relayout) {
+    if (!loaded_resources.empty()) {
         assert(maybe_page_);
-        engine_->relayout(page(), make_options());
+        engine_->resources_loaded(page(), make_options(), loaded_resources);
         on_layout_updated();
         process_iterations_ = 5;
     }
@@ -776,12 +777,12 @@ layout::LayoutBox const *App::get_hovered_node(geom::Position document_position)
         return nullptr;
     }
 
-    auto const &maybe_layout = page().layout;
-    if (!maybe_layout.has_value()) {
+    auto const &box_index = page().box_index;
+    if (!box_index.has_value()) {
         return nullptr;
     }
 
-    return layout::box_at_position(*maybe_layout, document_position);
+    return box_index->box_at_position(document_position);
 }
 
 geom::Position App::to_document_position(geom::Position window_position) const {
@@ -804,9 +805,9 @@ void App::scroll(int pixels) {
         return;
     }
 
-    auto const &layout = *maybe_layout;
+    auto const page_height = geom::snapped(maybe_layout->dimensions.margin_box()).height;
     // Don't allow scrolling if the entire page fits on the screen.
-    if (std::cmp_greater(window_.getSize().y / scale_, layout.dimensions.margin_box().height)) {
+    if (std::cmp_greater(window_.getSize().y / scale_, page_height)) {
         return;
     }
 
@@ -817,8 +818,8 @@ void App::scroll(int pixels) {
 
     int current_bottom_visible_y = static_cast<int>(window_.getSize().y / scale_) - scroll_offset_y_;
     int scrolled_bottom_visible_y = current_bottom_visible_y - pixels;
-    if (scrolled_bottom_visible_y > layout.dimensions.margin_box().height) {
-        pixels -= layout.dimensions.margin_box().height - scrolled_bottom_visible_y;
+    if (scrolled_bottom_visible_y > page_height) {
+        pixels -= page_height - scrolled_bottom_visible_y;
     }
 
     canvas_->add_translation(0, pixels);
@@ -945,20 +946,24 @@ void App::render_layout() {
     if (render_debug_) {
         render::debug::render_layout_depth(*canvas_, *layout);
     } else {
-        render::render_layout(*canvas_,
-                *layout,
-                std::optional{geom::Rect{0,
-                        -scroll_offset_y_,
-                        static_cast<int>(window_.getSize().x),
-                        static_cast<int>(window_.getSize().y)}},
-                [this](std::string_view id) -> std::optional<render::ImageView> {
-                    auto it = images_.find(id);
-                    if (it == end(images_)) {
-                        return std::nullopt;
-                    }
-
-                    return render::ImageView{it->second.width, it->second.height, it->second.rgba_bytes};
-                });
+        auto image_lookup = [this](std::string_view id) -> std::optional<render::ImageView> {
+            auto it = images_.find(id);
+            if (it == end(images_)) {
+                return std::nullopt;
+            }
+
+            return render::ImageView{it->second.width, it->second.height, it->second.rgba_bytes};
+        };
+
+        auto clip = geom::Rect{0,
+                -scroll_offset_y_,
+                static_cast<int>(window_.getSize().x),
+                static_cast<int>(window_.getSize().y)};
+        if (auto const &box_index = page().box_index) {
+            render::render_layout(*canvas_, *layout, *box_index, clip, image_lookup);
+        } else {
+            render::render_layout(*canvas_, *layout, clip, image_lookup);
+        }
     }
 }
 
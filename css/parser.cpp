@@ -19,10 +19,12 @@
 #include <cassert>
 #include <charconv>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <format>
+#include <future>
 #include <iterator>
 #include <optional>
 #include <string>
@@ -289,6 +291,59 @@ std::optional<std::string_view> try_parse_font_stretch(Tokenizer &tokenizer) {
     return std::nullopt;
 }
 
+// Parallel parsing isn't worth the thread overhead for small chunks.
+constexpr std::size_t kMinParallelChunkSize = std::size_t{16} * 1024;
+
+// Returns the start of each chunk followed by the end of the input. Chunks are
+// split right after a '}' closing a top-level rule or block, skipping over
+// strings and comments.
+std::vector<std::size_t> find_chunk_boundaries(std::string_view input, std::size_t chunk_count) {
+    std::vector<std::size_t> boundaries{0};
+    std::size_t const target_chunk_size = input.size() / chunk_count;
+    std::size_t depth{0};
+
+    for (std::size_t i = 0; i < input.size() && boundaries.size() < chunk_count; ++i) {
+        switch (auto c = input[i]) {
+            case '/':
+                if (input.substr(i, 2) == "/*") {
+                    i = input.find("*/", i + 2);
+                    if (i == std::string_view::npos) {
+                        i = input.size();
+                    } else {
+                        i += 1;
+                    }
+                }
+                break;
+            case '"':
+            case '\'':
+                for (i += 1; i < input.size() && input[i] != c && input[i] != '\n'; ++i) {
+                    if (input[i] == '\\') {
+                        i += 1;
+                    }
+                }
+                break;
+            case '{':
+                depth += 1;
+                break;
+            case '}':
+                if (depth == 0) {
+                    break;
+                }
+
+                depth -= 1;
+                if (depth == 0 && i + 1 - boundaries.back() >= target_chunk_size && i + 1 < input.size()) {
+                    boundaries.push_back(i + 1);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    boundaries.push_back(input.size());
+    return boundaries;
+}
+
 } // namespace
 
 // Not in header order, but must be defined before Parser::parse_rules() that
@@ -300,13 +355,15 @@ constexpr std::optional<std::string_view> Parser::consume_while(std::predicate<c
     }
 
     if (is_eof()) {
+        hit_eof_ = true;
         return std::nullopt;
     }
 
     return input_.substr(start, pos_ - start);
 }
 
-constexpr std::optional<std::string> Parser::consume_while_ignoring_comments(std::predicate<char> auto const &pred) {
+constexpr std::optional<std::string> Parser::consume_while_ignoring_comments(
+        std::predicate<char> auto const &pred, bool allow_eof) {
     std::string res;
 
     std::size_t start = pos_;
@@ -328,7 +385,14 @@ constexpr std::optional<std::string> Parser::consume_while_ignoring_comments(std
     }
 
     if (is_eof()) {
-        return std::nullopt;
+        hit_eof_ = true;
+        if (!allow_eof) {
+            return std::nullopt;
+        }
+
+        // Skipping an unterminated comment may have taken us past the end.
+        pos_ = input_.size();
+        start = std::min(start, pos_);
     }
 
     res += input_.substr(start, pos_ - start);
@@ -337,7 +401,6 @@ constexpr std::optional<std::string> Parser::consume_while_ignoring_comments(std
 
 StyleSheet Parser::parse_rules() {
     StyleSheet style;
-    bool in_media_query{false};
     std::optional<MediaQuery> media_query;
 
     skip_whitespace_and_comments();
@@ -370,7 +433,7 @@ StyleSheet Parser::parse_rules() {
             if (auto last_char = tmp_query->find_last_not_of(' '); last_char != std::string_view::npos) {
                 tmp_query->remove_suffix(tmp_query->size() - (last_char + 1));
             }
-            in_media_query = true;
+            in_media_query_ = true;
             media_query = MediaQuery::parse(*tmp_query);
             if (!media_query) {
                 spdlog::warn("Unable to parse media query: '{}'", *tmp_query);
@@ -427,9 +490,9 @@ StyleSheet Parser::parse_rules() {
 
         skip_whitespace_and_comments();
 
-        if (in_media_query && peek() == '}') {
+        if (in_media_query_ && peek() == '}') {
             media_query = {};
-            in_media_query = false;
+            in_media_query_ = false;
             consume_char(); // }
             skip_whitespace_and_comments();
         }
@@ -438,6 +501,97 @@ StyleSheet Parser::parse_rules() {
     return style;
 }
 
+StyleSheet Parser::parse_rules_parallel(std::string_view input, std::size_t max_threads) {
+    auto chunk_count = std::min(max_threads, input.size() / kMinParallelChunkSize);
+    if (chunk_count <= 1) {
+        return Parser{input}.parse_rules();
+    }
+
+    enum class Outcome : std::uint8_t {
+        // Parsing stopped at the end of the chunk, outside of any block.
+        Complete,
+        // Parsing stopped on an error unrelated to the end of the chunk, so
+        // the sequential parser would also stop here.
+        Error,
+        // The parser needed to look past the end of the chunk, so the chunk
+        // boundary wasn't a rule boundary as far as the parser is concerned,
+        // e.g. because of a '}' in a string, which the parser doesn't handle.
+        Misaligned,
+    };
+
+    struct ChunkResult {
+        StyleSheet style;
+        Outcome outcome{};
+    };
+
+    auto parse_chunk = [](std::string_view chunk) {
+        Parser parser{chunk};
+        auto style = parser.parse_rules();
+        if (parser.hit_eof_ || parser.in_media_query_ || parser.pos_ > chunk.size()) {
+            return ChunkResult{std::move(style), Outcome::Misaligned};
+        }
+
+        return ChunkResult{std::move(style), parser.is_eof() ? Outcome::Complete : Outcome::Error};
+    };
+
+    auto boundaries = find_chunk_boundaries(input, chunk_count);
+    std::vector<std::future<ChunkResult>> future_chunks;
+    future_chunks.reserve(boundaries.size() - 2);
+    for (std::size_t i = 1; i + 1 < boundaries.size(); ++i) {
+        auto chunk = input.substr(boundaries[i], boundaries[i + 1] - boundaries[i]);
+        future_chunks.push_back(std::async(std::launch::async, parse_chunk, chunk));
+    }
+
+    auto const last_chunk = boundaries.size() - 2;
+    auto first = parse_chunk(input.substr(0, boundaries[1]));
+    StyleSheet style;
+    for (std::size_t i = 0; i <= last_chunk; ++i) {
+        auto chunk = i == 0 ? std::move(first) : future_chunks[i - 1].get();
+        if (chunk.outcome == Outcome::Misaligned && i != last_chunk) {
+            // The sequential parser wouldn't have been at a rule boundary
+            // here, so the rest of the input has to be parsed in one go.
+            style.splice(Parser{input.substr(boundaries[i])}.parse_rules());
+            break;
+        }
+
+        style.splice(std::move(chunk.style));
+        if (chunk.outcome == Outcome::Error) {
+            break;
+        }
+    }
+
+    return style;
+}
+
+std::optional<Rule> Parser::parse_declarations() {
+    Rule rule{};
+
+    skip_whitespace_and_comments();
+    while (!is_eof()) {
+        // The last declaration doesn't need a terminating ';'.
+        auto declaration =
+                consume_while_ignoring_comments([](char c) { return c != ';' && c != '{' && c != '}'; }, true);
+        if (!declaration || declaration->empty() || (!is_eof() && peek() != ';')) {
+            return std::nullopt;
+        }
+
+        auto decl = parse_declaration(*declaration);
+        if (!decl) {
+            return std::nullopt;
+        }
+
+        if (peek() == ';') {
+            consume_char(); // ;
+        }
+
+        auto [name, value] = *decl;
+        add_declaration(rule, name, value);
+        skip_whitespace_and_comments();
+    }
+
+    return rule;
+}
+
 constexpr std::optional<char> Parser::peek() const {
     if (is_eof()) {
         return std::nullopt;
@@ -466,6 +620,7 @@ constexpr void Parser::skip_if_neq(char c) {
 
 constexpr std::optional<char> Parser::consume_char() {
     if (is_eof()) {
+        hit_eof_ = true;
         return std::nullopt;
     }
 
@@ -566,19 +721,7 @@ bool Parser::parse_rule(StyleSheet &style, std::optional<MediaQuery> const &acti
         }
 
         auto [name, value] = *decl;
-        if (name.starts_with("--")) {
-            rule.custom_properties.insert_or_assign(std::string{name}, value);
-        } else if (auto name_start_byte = name.front(); name_start_byte == '-') {
-            // We don't really care about the -moz, -ms, -webkit, or similar prefixed properties.
-            spdlog::debug("Ignoring vendor-prefixed property: '{}'", name);
-        } else if (!util::is_alpha(name_start_byte)) {
-            spdlog::warn("Ignoring unknown property: '{}'", name);
-        } else if (value.ends_with("!important")) {
-            value.remove_suffix(std::strlen("!important"));
-            add_declaration(rule.important_declarations, name, util::trim(value));
-        } else {
-            add_declaration(rule.declarations, name, value);
-        }
+        add_declaration(rule, name, value);
         skip_whitespace_and_comments();
     }
 
@@ -600,6 +743,22 @@ std::optional<std::pair<std::string_view, std::string_view>> Parser::parse_decla
     return std::pair{name, value};
 }
 
+void Parser::add_declaration(Rule &rule, std::string_view name, std::string_view value) {
+    if (name.starts_with("--")) {
+        rule.custom_properties.insert_or_assign(std::string{name}, value);
+    } else if (auto name_start_byte = name.front(); name_start_byte == '-') {
+        // We don't really care about the -moz, -ms, -webkit, or similar prefixed properties.
+        spdlog::debug("Ignoring vendor-prefixed property: '{}'", name);
+    } else if (!util::is_alpha(name_start_byte)) {
+        spdlog::warn("Ignoring unknown property: '{}'", name);
+    } else if (value.ends_with("!important")) {
+        value.remove_suffix(std::strlen("!important"));
+        add_declaration(rule.important_declarations, name, util::trim(value));
+    } else {
+        add_declaration(rule.declarations, name, value);
+    }
+}
+
 void Parser::add_declaration(Declarations &declarations, std::string_view name, std::string_view value) {
     if (is_shorthand_edge_property(name)) {
         expand_edge_values(declarations, name, value);
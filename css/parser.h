@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2021 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -17,6 +17,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 
 namespace css {
@@ -27,10 +28,23 @@ public:
 
     StyleSheet parse_rules();
 
+    // Parses the input as the contents of a declaration block, e.g. a style
+    // attribute. Returns nullopt on parse errors.
+    std::optional<Rule> parse_declarations();
+
+    // Splits the input at top-level rule boundaries and parses the pieces on
+    // up to `max_threads` threads. The result is identical to parse_rules().
+    static StyleSheet parse_rules_parallel(std::string_view input, std::size_t max_threads);
+
 private:
     std::string_view input_;
     std::size_t pos_{};
 
+    bool in_media_query_{false};
+    // Set if the parser looked past the end of the input, meaning that the
+    // result may have been different had there been more input.
+    bool hit_eof_{false};
+
     // Parse helpers.
     constexpr bool is_eof() const { return pos_ >= input_.size(); }
     constexpr std::optional<char> peek() const;
@@ -41,7 +55,8 @@ private:
     constexpr std::optional<char> consume_char();
 
     constexpr std::optional<std::string_view> consume_while(std::predicate<char> auto const &);
-    constexpr std::optional<std::string> consume_while_ignoring_comments(std::predicate<char> auto const &);
+    constexpr std::optional<std::string> consume_while_ignoring_comments(
+            std::predicate<char> auto const &, bool allow_eof = false);
 
     constexpr void skip_whitespace();
 
@@ -53,6 +68,7 @@ private:
     [[nodiscard]] bool parse_rule(
             StyleSheet &, std::optional<MediaQuery> const &active_media_query, Rule const *parent);
     static std::optional<std::pair<std::string_view, std::string_view>> parse_declaration(std::string_view declaration);
+    static void add_declaration(Rule &, std::string_view name, std::string_view value);
 
     static void add_declaration(Declarations &, std::string_view name, std::string_view value);
 
@@ -91,6 +107,15 @@ inline StyleSheet parse(std::string_view input) {
     return Parser{input}.parse_rules();
 }
 
+inline std::optional<Rule> parse_declarations(std::string_view input) {
+    return Parser{input}.parse_declarations();
+}
+
+inline StyleSheet parse_parallel(
+        std::string_view input, std::size_t max_threads = std::thread::hardware_concurrency()) {
+    return Parser::parse_rules_parallel(input, max_threads);
+}
+
 } // namespace css
 
 #endif
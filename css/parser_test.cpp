@@ -1492,5 +1492,93 @@ int main() {
         a.expect_eq(rules, std::vector<css::Rule>{});
     });
 
+    s.add_test("parse_parallel: same result as parse", [](etest::IActions &a) {
+        std::string css;
+        for (int i = 0; i < 2000; ++i) {
+            css += std::format(".a{0}, .b{0} {{ color: #{0}; margin: 1px 2px; }}\n", i);
+            css += std::format("/* {{ }} */ p{0} {{ content: \"a\"; font: 12px serif; a {{ color: red; }} }}\n", i);
+            css += std::format("@media (min-width: {0}px) {{ div{0} {{ width: {0}px; }} }}\n", i);
+            css += std::format("@font-face {{ font-family: f{0}; }} @keyframes k{0} {{ from {{ top: 0; }} }}\n", i);
+        }
+
+        auto expected = css::parse(css);
+        a.expect(expected.rules.size() > 8000);
+        for (std::size_t threads : {1, 2, 3, 8, 64}) {
+            a.expect_eq(css::parse_parallel(css, threads), expected);
+        }
+    });
+
+    s.add_test("parse_parallel: misaligned chunks", [](etest::IActions &a) {
+        // The '}' in the strings will be seen as the end of the rules by the
+        // parser, but not by the chunking.
+        std::string css;
+        for (int i = 0; i < 2000; ++i) {
+            css += std::format("p{0} {{ content: '}}'; color: red; }}\n", i);
+        }
+
+        auto expected = css::parse(css);
+        a.expect_eq(expected.rules.size(), std::size_t{2000});
+        for (std::size_t threads : {2, 4, 16}) {
+            a.expect_eq(css::parse_parallel(css, threads), expected);
+        }
+    });
+
+    s.add_test("parse_parallel: errors stop parsing", [](etest::IActions &a) {
+        std::string css;
+        for (int i = 0; i < 2000; ++i) {
+            css += std::format("p{0} {{ color: red; }}\n", i);
+            if (i == 1000) {
+                css += "a { : 3px; }\n";
+            }
+        }
+
+        auto expected = css::parse(css);
+        a.expect_eq(expected.rules.size(), std::size_t{1001});
+        for (std::size_t threads : {2, 4, 16}) {
+            a.expect_eq(css::parse_parallel(css, threads), expected);
+        }
+    });
+
+    s.add_test("parse_parallel: eof", [](etest::IActions &a) {
+        std::string css;
+        for (int i = 0; i < 2000; ++i) {
+            css += std::format("p{0} {{ color: red; }}\n", i);
+        }
+        css += "/* p { color: green; }";
+
+        auto expected = css::parse(css);
+        a.expect_eq(css::parse_parallel(css, 4), expected);
+
+        css += " */ @media (min-width: 5px) { a { color: blue; }";
+        expected = css::parse(css);
+        a.expect_eq(css::parse_parallel(css, 4), expected);
+    });
+
+    s.add_test("parse_declarations", [](etest::IActions &a) {
+        auto rule = css::parse_declarations(" color: red; --var: 5px;margin: 0 !important; /* hi */ width: 3px ");
+        a.expect_eq(rule,
+                css::Rule{
+                        .declarations{{css::PropertyId::Color, "red"}, {css::PropertyId::Width, "3px"}},
+                        .important_declarations{
+                                {css::PropertyId::MarginTop, "0"},
+                                {css::PropertyId::MarginRight, "0"},
+                                {css::PropertyId::MarginBottom, "0"},
+                                {css::PropertyId::MarginLeft, "0"},
+                        },
+                        .custom_properties{{"--var", "5px"}},
+                });
+
+        a.expect_eq(css::parse_declarations(""), css::Rule{});
+        a.expect_eq(css::parse_declarations("color: red; /* unterminated"),
+                css::Rule{.declarations{{css::PropertyId::Color, "red"}}});
+    });
+
+    s.add_test("parse_declarations: errors", [](etest::IActions &a) {
+        a.expect_eq(css::parse_declarations("color: red;;"), std::nullopt);
+        a.expect_eq(css::parse_declarations("color"), std::nullopt);
+        a.expect_eq(css::parse_declarations("color: red} p { color: blue"), std::nullopt);
+        a.expect_eq(css::parse_declarations("p { color: blue; }"), std::nullopt);
+    });
+
     return s.run();
 }
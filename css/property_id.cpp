@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <map>
 #include <string_view>
 #include <utility>
@@ -261,7 +262,15 @@ std::string_view to_string(PropertyId id) {
 }
 
 std::string_view initial_value(PropertyId id) {
-    return std::ranges::find(kInitialValues, id, &decltype(kInitialValues)::value_type::first)->second;
+    static constexpr auto kInitialValueTable = [] {
+        std::array<std::string_view, kPropertyIdCount> table{};
+        for (auto const &[property, value] : kInitialValues) {
+            table[static_cast<std::size_t>(property)] = value;
+        }
+        return table;
+    }();
+
+    return kInitialValueTable[static_cast<std::size_t>(id)];
 }
 
 } // namespace css
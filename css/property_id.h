@@ -5,6 +5,7 @@
 #ifndef CSS_PROPERTY_ID_H_
 #define CSS_PROPERTY_ID_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 
@@ -120,9 +121,14 @@ enum class PropertyId : std::uint8_t {
     WhiteSpace,
     Widows,
     Width,
-    WordSpacing, // When adding an id after this, remember to update the property id -> string test.
+    // When adding an id after this, remember to update kPropertyIdCount and
+    // the property id -> string test.
+    WordSpacing,
 };
 
+// For tables indexed by PropertyId.
+inline constexpr std::size_t kPropertyIdCount = static_cast<std::size_t>(PropertyId::WordSpacing) + 1;
+
 PropertyId property_id_from_string(std::string_view);
 
 std::string_view to_string(PropertyId);
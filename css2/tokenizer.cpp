@@ -11,9 +11,12 @@
 #include "util/string.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <charconv>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <optional>
 #include <string>
@@ -58,6 +61,53 @@ constexpr bool is_non_printable(char c) {
     return (c >= 0x00 && c <= 0x08) || c == 0x0B || (c >= 0x0E && c <= 0x1F) || c == 0x7F;
 }
 
+// SWAR (SIMD within a register) helpers for skipping over runs of
+// uninteresting bytes 8 at a time. Each helper sets the high bit of every byte
+// in the word that matches, and clears all other bits.
+constexpr std::uint64_t kOnes = 0x0101010101010101;
+constexpr std::uint64_t kHighBits = kOnes * 0x80;
+constexpr std::uint64_t kLowBits = ~kHighBits;
+
+constexpr std::uint64_t bytes_equal_to(std::uint64_t word, char c) {
+    auto x = word ^ (kOnes * static_cast<std::uint8_t>(c));
+    return ~(((x & kLowBits) + kLowBits) | x | kLowBits);
+}
+
+// Only valid for limit <= 0x80. Bytes w/ the high bit set never match.
+constexpr std::uint64_t bytes_less_than(std::uint64_t word, std::uint8_t limit) {
+    return ~((word | kHighBits) - kOnes * limit) & ~word & kHighBits;
+}
+
+constexpr std::uint64_t whitespace_bytes(std::uint64_t word) {
+    return bytes_equal_to(word, ' ') | bytes_equal_to(word, '\n') | bytes_equal_to(word, '\t');
+}
+
+// Returns the index of the first byte at or after `pos` where `word_matches`
+// (operating on 8 bytes at a time) or `byte_matches` (operating on the tail)
+// is true, or max(pos, input.size()) if there is no such byte.
+template<typename WordPred, typename BytePred>
+std::size_t find_first(std::string_view input, std::size_t pos, WordPred word_matches, BytePred byte_matches) {
+    for (; pos + sizeof(std::uint64_t) <= input.size(); pos += sizeof(std::uint64_t)) {
+        std::uint64_t word{};
+        std::memcpy(&word, input.data() + pos, sizeof(word));
+        if (auto matches = word_matches(word); matches != 0) {
+            if constexpr (std::endian::native == std::endian::little) {
+                return pos + static_cast<std::size_t>(std::countr_zero(matches)) / 8;
+            } else {
+                return pos + static_cast<std::size_t>(std::countl_zero(matches)) / 8;
+            }
+        }
+    }
+
+    for (; pos < input.size(); ++pos) {
+        if (byte_matches(input[pos])) {
+            return pos;
+        }
+    }
+
+    return pos;
+}
+
 } // namespace
 
 std::string_view to_string(ParseError e) {
@@ -92,11 +142,11 @@ void Tokenizer::run() {
         }
 
         if (is_whitespace(*c)) {
-            while (is_whitespace(consume_next_input_character())) {
-                // Do nothing.
-            }
-
-            reconsume();
+            pos_ = find_first(
+                    input_,
+                    pos_,
+                    [](std::uint64_t word) { return ~whitespace_bytes(word) & kHighBits; },
+                    [](char byte) { return !is_whitespace(byte); });
             emit(WhitespaceToken{});
             continue;
         }
@@ -328,6 +378,21 @@ Token Tokenizer::consume_string(char ending_code_point) {
     std::string result;
 
     while (true) {
+        // Everything up until the ending code point, a newline, or an escape
+        // is copied into the string as-is.
+        auto plain_end = find_first(
+                input_,
+                pos_,
+                [&](std::uint64_t word) {
+                    return bytes_equal_to(word, ending_code_point) | bytes_equal_to(word, '\n')
+                            | bytes_equal_to(word, '\\');
+                },
+                [&](char byte) { return byte == ending_code_point || byte == '\n' || byte == '\\'; });
+        if (plain_end > pos_) {
+            result.append(input_.substr(pos_, plain_end - pos_));
+            pos_ = plain_end;
+        }
+
         auto c = consume_next_input_character();
 
         if (!c) {
@@ -569,6 +634,25 @@ Token Tokenizer::consume_a_url_token() {
     std::string url;
 
     while (true) {
+        // Anything that isn't whitespace, a control character, or one of
+        // `)"'(\` can be copied into the url as-is.
+        auto plain_end = find_first(
+                input_,
+                pos_,
+                [](std::uint64_t word) {
+                    return bytes_less_than(word, 0x20) | bytes_equal_to(word, 0x7F) | bytes_equal_to(word, ' ')
+                            | bytes_equal_to(word, ')') | bytes_equal_to(word, '"') | bytes_equal_to(word, '\'')
+                            | bytes_equal_to(word, '(') | bytes_equal_to(word, '\\');
+                },
+                [](char byte) {
+                    return static_cast<unsigned char>(byte) < 0x20 || byte == 0x7F || byte == ' ' || byte == ')'
+                            || byte == '"' || byte == '\'' || byte == '(' || byte == '\\';
+                });
+        if (plain_end > pos_) {
+            url.append(input_.substr(pos_, plain_end - pos_));
+            pos_ = plain_end;
+        }
+
         auto c = consume_next_input_character();
         if (!c) {
             emit(ParseError::EofInUrl);
@@ -635,21 +719,16 @@ void Tokenizer::consume_the_remnants_of_a_bad_url() {
 
 void Tokenizer::consume_comments() {
     while (peek_input(0) == '/' && peek_input(1) == '*') {
-        std::ignore = consume_next_input_character(); // '/'
-        std::ignore = consume_next_input_character(); // '*'
-
-        while (true) {
-            auto c = consume_next_input_character();
-            if (!c) {
-                emit(ParseError::EofInComment);
-                return;
-            }
+        pos_ += 2; // '/*'
 
-            if (*c == '*' && peek_input(0) == '/') {
-                std::ignore = consume_next_input_character();
-                break;
-            }
+        auto comment_end = input_.find("*/", pos_);
+        if (comment_end == std::string_view::npos) {
+            pos_ = input_.size();
+            emit(ParseError::EofInComment);
+            return;
         }
+
+        pos_ = comment_end + 2;
     }
 }
 
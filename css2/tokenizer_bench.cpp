@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "css2/tokenizer.h"
+
+#include "css2/token.h"
+
+#include "etest/etest2.h"
+
+#include <nanobench.h>
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// Generates something shaped like a utility-first CSS framework bundle:
+// custom properties, lots of small rules, media queries, strings, urls, and
+// (when not minified) comments and indentation.
+std::string make_framework_css(bool minified, int rule_groups) {
+    std::string const indent = minified ? "" : "  ";
+    std::string const colon = minified ? ":" : ": ";
+    std::string const open = minified ? "{" : " {\n";
+    std::string const close = minified ? "}" : "}\n";
+    std::string const end = minified ? ";" : ";\n";
+
+    std::string css;
+    auto comment = [&](std::string const &text) {
+        if (!minified) {
+            css += "/* " + text + " */\n";
+        }
+    };
+
+    auto rule = [&](std::string const &selector, std::string const &property, std::string const &value) {
+        css += selector + open + indent + property + colon + value + end + close;
+    };
+
+    comment("Licensed under the MIT license. This is a long header comment, as is tradition.");
+    css += ":root" + open;
+    for (int i = 0; i < 64; ++i) {
+        auto const n = std::to_string(i);
+        css += indent + "--fw-color-" + n + colon + "#0d6efd" + end;
+        css += indent + "--fw-font-" + n + colon
+                + R"(system-ui, -apple-system, "Segoe UI", Roboto, "Helvetica Neue", "Noto Sans", Arial)" + end;
+    }
+    css += close;
+
+    for (int i = 0; i < rule_groups; ++i) {
+        auto const n = std::to_string(i);
+        comment("Utilities for group " + n + ", generated from the spacing and color maps.");
+        rule(".m-" + n, "margin", "0.25rem !important");
+        rule(".p-" + n, "padding", "0.5rem 1rem !important");
+        rule(".text-" + n + ":hover", "color", "rgba(13, 110, 253, 0.75) !important");
+        rule(".btn-close-" + n,
+                "background",
+                R"(transparent url("data:image/svg+xml,%3csvg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 16 16')"
+                R"(%3e%3cpath d='M.293.293a1 1 0 0 1 1.414 0L8 6.586'/%3e%3c/svg%3e") center/1em auto no-repeat)");
+        rule(".icon-" + n, "background-image", "url(/assets/images/icons/sprite-" + n + ".svg)");
+        rule(".quote-" + n + "::before", "content", R"("\201C  quoted  text  \201D")");
+
+        css += "@media (min-width" + colon + "576px)" + open;
+        rule(indent + ".col-sm-" + n, "width", "8.33333333%");
+        css += close;
+    }
+
+    return css;
+}
+
+std::size_t count_tokens(std::string_view input) {
+    std::size_t tokens{};
+    css2::Tokenizer{input, [&](css2::Token &&) { ++tokens; }, [](css2::ParseError) {}}.run();
+    return tokens;
+}
+
+} // namespace
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("tokenizer throughput", [](etest::IActions &a) {
+        ankerl::nanobench::Bench bench;
+        bench.title("css2::Tokenizer").unit("byte");
+
+        auto run = [&](std::string const &name, std::string const &css) {
+            a.expect(count_tokens(css) > 0);
+            bench.batch(css.size()).run(name, [&] {
+                ankerl::nanobench::doNotOptimizeAway(count_tokens(css)); //
+            });
+
+            auto seconds = bench.results().back().median(ankerl::nanobench::Result::Measure::elapsed);
+            std::cout << name << ": " << (static_cast<double>(css.size()) / seconds / 1'000'000.) << " MB/s\n";
+        };
+
+        run("unminified framework css", make_framework_css(false, 2000));
+        run("minified framework css", make_framework_css(true, 2000));
+    });
+
+    return s.run();
+}
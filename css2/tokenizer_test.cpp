@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -145,6 +145,12 @@ int main() {
         expect_error(output, ParseError::EofInComment);
     });
 
+    s.add_test("long comment", [](etest::IActions &a) {
+        auto output = run_tokenizer(a, "/* this comment is long enough to span several words * / */?");
+
+        expect_token(output, DelimToken{'?'});
+    });
+
     s.add_test("space and comments", [](etest::IActions &a) {
         auto output = run_tokenizer(a, " /* */   /**/");
 
@@ -180,6 +186,14 @@ int main() {
         expect_token(output, WhitespaceToken{});
     });
 
+    s.add_test("long whitespace run", [](etest::IActions &a) {
+        auto output = run_tokenizer(a, "a \t\n                 \n\t\t   \n b");
+
+        expect_token(output, IdentToken{"a"});
+        expect_token(output, WhitespaceToken{});
+        expect_token(output, IdentToken{"b"});
+    });
+
     s.add_test("single quoted string", [](etest::IActions &a) {
         auto output = run_tokenizer(a, "'this is a string'");
 
@@ -217,6 +231,12 @@ int main() {
         expect_token(output, StringToken{"foo@"});
     });
 
+    s.add_test("long string with escapes", [](etest::IActions &a) {
+        auto output = run_tokenizer(a, R"('this string is long enough \41nd has \'quotes\' in it')");
+
+        expect_token(output, StringToken{"this string is long enough And has 'quotes' in it"});
+    });
+
     s.add_test("string, escape before eof", [](etest::IActions &a) {
         auto output = run_tokenizer(a, "'foo\\");
         expect_error(output, ParseError::EofInString);
@@ -739,6 +759,17 @@ int main() {
         });
     }
 
+    s.add_test("url: long", [](etest::IActions &a) {
+        auto output = run_tokenizer(a, "url(https://example.com/some/long/path/to/\\41n/image.png)");
+        expect_token(output, UrlToken{.data = "https://example.com/some/long/path/to/An/image.png"});
+    });
+
+    s.add_test("url: long, bad url", [](etest::IActions &a) {
+        auto output = run_tokenizer(a, "url(https://example.com/some/long/path/to/an/ima\x7fge.png)");
+        expect_error(output, ParseError::DisallowedCharacterInUrl);
+        expect_token(output, BadUrlToken{});
+    });
+
     s.add_test("url: escape", [](etest::IActions &a) {
         auto output = run_tokenizer(a, "url(\\41)");
         expect_token(output, UrlToken{.data = "A"});
@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "dom/mutation_log.h"
+
+#include "dom/dom.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dom {
+
+void MutationLog::set_attribute(Element &element, std::string_view name, std::string value) {
+    auto it = element.attributes.find(name);
+    if (it == element.attributes.end()) {
+        attribute_changes_.push_back({&element, std::string{name}, std::nullopt});
+        element.attributes.emplace(std::string{name}, std::move(value));
+        return;
+    }
+
+    if (it->second == value) {
+        return;
+    }
+
+    attribute_changes_.push_back({&element, std::string{name}, std::exchange(it->second, std::move(value))});
+}
+
+void MutationLog::remove_attribute(Element &element, std::string_view name) {
+    auto it = element.attributes.find(name);
+    if (it == element.attributes.end()) {
+        return;
+    }
+
+    attribute_changes_.push_back({&element, std::string{name}, std::move(it->second)});
+    element.attributes.erase(it);
+}
+
+} // namespace dom
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef DOM_MUTATION_LOG_H_
+#define DOM_MUTATION_LOG_H_
+
+#include "dom/dom.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dom {
+
+struct AttributeChange {
+    Element const *element{};
+    std::string name;
+    // nullopt if the attribute didn't exist before the change.
+    std::optional<std::string> old_value;
+    [[nodiscard]] bool operator==(AttributeChange const &) const = default;
+};
+
+// Modifies elements while keeping track of what's been changed so that
+// things derived from the DOM, like the style tree, can be updated w/o
+// having to start over from scratch.
+class MutationLog {
+public:
+    void set_attribute(Element &, std::string_view name, std::string value);
+    void remove_attribute(Element &, std::string_view name);
+
+    [[nodiscard]] std::vector<AttributeChange> const &attribute_changes() const { return attribute_changes_; }
+    [[nodiscard]] bool empty() const { return attribute_changes_.empty(); }
+    void clear() { attribute_changes_.clear(); }
+
+private:
+    std::vector<AttributeChange> attribute_changes_;
+};
+
+} // namespace dom
+
+#endif
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "dom/mutation_log.h"
+
+#include "dom/dom.h"
+#include "etest/etest2.h"
+
+#include <vector>
+
+int main() {
+    etest::Suite s{"dom::MutationLog"};
+
+    s.add_test("set_attribute", [](etest::IActions &a) {
+        dom::Element element{"div", {{"class", "a"}}};
+        dom::MutationLog log;
+
+        log.set_attribute(element, "class", "b");
+        log.set_attribute(element, "id", "c");
+        a.expect_eq(element.attributes, dom::AttrMap{{"class", "b"}, {"id", "c"}});
+        a.expect_eq(log.attribute_changes(),
+                std::vector<dom::AttributeChange>{
+                        {&element, "class", "a"},
+                        {&element, "id", std::nullopt},
+                });
+    });
+
+    s.add_test("set_attribute, no change", [](etest::IActions &a) {
+        dom::Element element{"div", {{"class", "a"}}};
+        dom::MutationLog log;
+
+        log.set_attribute(element, "class", "a");
+        a.expect(log.empty());
+    });
+
+    s.add_test("remove_attribute", [](etest::IActions &a) {
+        dom::Element element{"div", {{"class", "a"}}};
+        dom::MutationLog log;
+
+        log.remove_attribute(element, "id");
+        a.expect(log.empty());
+
+        log.remove_attribute(element, "class");
+        a.expect(element.attributes.empty());
+        a.expect_eq(log.attribute_changes(), std::vector<dom::AttributeChange>{{&element, "class", "a"}});
+
+        log.clear();
+        a.expect(log.empty());
+    });
+
+    return s.run();
+}
@@ -16,17 +16,21 @@
 #include "html/parse.h"
 #include "html/parse_error.h"
 #include "js/parser.h"
+#include "layout/box_index.h"
 #include "layout/layout.h"
 #include "protocol/response.h"
 #include "style/style.h"
+#include "style/styled_node.h"
 #include "uri/uri.h"
 #include "util/string.h"
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <expected>
+#include <functional>
 #include <future>
 #include <memory>
 #include <ranges>
@@ -120,6 +124,41 @@ css::MediaQuery::Context to_media_context(Options opts) {
     };
 }
 
+// The index points into the styled tree, so it has to be rebuilt whenever that's recreated.
+void index_styles(PageState &state) {
+    state.styled_elements.clear();
+    if (state.styled != nullptr) {
+        style::index_styled_elements(*state.styled, state.styled_elements);
+    }
+}
+
+// The index points into the layout, so it has to be rebuilt whenever that changes.
+void index_layout(PageState &state) {
+    if (state.layout.has_value()) {
+        state.box_index.emplace(*state.layout);
+    } else {
+        state.box_index.reset();
+    }
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void find_elements(style::StyledNode const &node,
+        std::function<bool(dom::Element const &)> const &pred,
+        std::vector<style::StyledNode const *> &found) {
+    auto const *element = std::get_if<dom::Element>(&node.node);
+    if (element == nullptr) {
+        return;
+    }
+
+    if (pred(*element)) {
+        found.push_back(&node);
+    }
+
+    for (auto const &child : node.children) {
+        find_elements(child, pred, found);
+    }
+}
+
 } // namespace
 
 std::expected<std::unique_ptr<PageState>, NavigationError> Engine::navigate(uri::Uri uri, Options opts) {
@@ -167,6 +206,7 @@ std::expected<std::unique_ptr<PageState>, NavigationError> Engine::navigate(uri:
 
     spdlog::info("Parsing inline styles");
     state->stylesheet = css::default_style();
+    state->user_agent_rules = state->stylesheet.rules.size();
     for (auto const &style : dom::nodes_by_xpath(state->dom.html(), "/html/head/style"sv)) {
         if (style->children.empty()) {
             continue;
@@ -188,10 +228,10 @@ std::expected<std::unique_ptr<PageState>, NavigationError> Engine::navigate(uri:
 
     // Start downloading all stylesheets.
     spdlog::info("Loading {} stylesheets", head_links.size());
-    std::vector<std::future<css::StyleSheet>> future_new_rules;
-    future_new_rules.reserve(head_links.size());
+    std::vector<std::future<std::string>> future_stylesheets;
+    future_stylesheets.reserve(head_links.size());
     for (auto const *link : head_links) {
-        future_new_rules.push_back(std::async(std::launch::async, [this, link, &state]() -> css::StyleSheet {
+        future_stylesheets.push_back(std::async(std::launch::async, [this, link, &state]() -> std::string {
             auto const &href = link->attributes.at("href");
             auto stylesheet_url = uri::Uri::parse(href, state->uri);
             if (!stylesheet_url) {
@@ -222,24 +262,31 @@ std::expected<std::unique_ptr<PageState>, NavigationError> Engine::navigate(uri:
                 return {};
             }
 
-            return css::parse(style_data->body);
+            return std::move(style_data->body);
         }));
     }
 
-    // In order, wait for the download to finish and merge with the big stylesheet.
-    for (auto &future_rules : future_new_rules) {
-        state->stylesheet.splice(future_rules.get());
+    // In order, wait for the download to finish, parse, and merge w/ the big
+    // stylesheet. External stylesheets tend to be large framework bundles, so
+    // they're parsed in parallel, but one at a time so that there are never
+    // more parsing threads than hardware threads.
+    for (auto &future_stylesheet : future_stylesheets) {
+        state->stylesheet.splice(css::parse_parallel(future_stylesheet.get()));
     }
 
     spdlog::info("Styling dom w/ {} rules", state->stylesheet.rules.size());
     state->layout_width = opts.layout_width;
     state->viewport_height = opts.viewport_height;
-    state->styled = style::style_tree(state->dom.html_node, state->stylesheet, to_media_context(opts));
+    state->rule_set.emplace(state->stylesheet, state->user_agent_rules);
+    state->styled = style::style_tree_parallel(
+            state->dom.html_node, *state->rule_set, state->inline_styles, to_media_context(opts));
+    index_styles(*state);
     spdlog::info("Building layout");
     state->layout = layout::create_layout(*state->styled,
-            {state->layout_width, state->viewport_height},
+            {state->layout_width, state->viewport_height, &text_measurements_},
             *type_,
             get_intrensic_size_for_resource_at_url_);
+    index_layout(*state);
 
     spdlog::info("Done navigating to {}", state->uri.uri);
     return state;
@@ -248,11 +295,73 @@ std::expected<std::unique_ptr<PageState>, NavigationError> Engine::navigate(uri:
 void Engine::relayout(PageState &state, Options opts) {
     state.layout_width = opts.layout_width;
     state.viewport_height = opts.viewport_height;
-    state.styled = style::style_tree(state.dom.html_node, state.stylesheet, to_media_context(opts));
+    if (!state.rule_set.has_value()) {
+        state.rule_set.emplace(state.stylesheet, state.user_agent_rules);
+    }
+
+    state.styled = style::style_tree_parallel(
+            state.dom.html_node, *state.rule_set, state.inline_styles, to_media_context(opts));
+    index_styles(state);
+    state.mutations.clear();
     state.layout = layout::create_layout(*state.styled,
-            {state.layout_width, state.viewport_height},
+            {state.layout_width, state.viewport_height, &text_measurements_},
+            *type_,
+            get_intrensic_size_for_resource_at_url_);
+    index_layout(state);
+}
+
+void Engine::restyle(PageState &state, Options opts) {
+    if (state.styled == nullptr || !state.rule_set.has_value() || state.layout_width != opts.layout_width
+            || state.viewport_height != opts.viewport_height) {
+        relayout(state, opts);
+        return;
+    }
+
+    std::vector<style::StyledNode const *> dirty;
+    auto const &changes = state.mutations.attribute_changes();
+    auto const rematched = style::restyle(
+            state.styled_elements, *state.rule_set, state.inline_styles, changes, to_media_context(opts), &dirty);
+    spdlog::info("Restyled {} elements after {} attribute changes", rematched, changes.size());
+
+    // Attributes like src and alt change what's laid out w/o changing any style.
+    for (auto const &change : changes) {
+        auto it = state.styled_elements.find(change.element);
+        if (it != state.styled_elements.end() && std::ranges::find(dirty, it->second) == dirty.end()) {
+            dirty.push_back(it->second);
+        }
+    }
+    state.mutations.clear();
+    layout::relayout(state.layout,
+            *state.styled,
+            dirty,
+            {state.layout_width, state.viewport_height, &text_measurements_},
+            *type_,
+            get_intrensic_size_for_resource_at_url_);
+    index_layout(state);
+}
+
+void Engine::resources_loaded(PageState &state, Options opts, std::span<std::string const> urls) {
+    if (state.styled == nullptr || state.layout_width != opts.layout_width
+            || state.viewport_height != opts.viewport_height) {
+        relayout(state, opts);
+        return;
+    }
+
+    std::vector<style::StyledNode const *> dirty;
+    find_elements(
+            *state.styled,
+            [&](dom::Element const &element) {
+                auto src = element.attributes.find("src");
+                return src != element.attributes.end() && std::ranges::find(urls, src->second) != urls.end();
+            },
+            dirty);
+    layout::relayout(state.layout,
+            *state.styled,
+            dirty,
+            {state.layout_width, state.viewport_height, &text_measurements_},
             *type_,
             get_intrensic_size_for_resource_at_url_);
+    index_layout(state);
 }
 
 Engine::LoadResult Engine::load(uri::Uri uri) {
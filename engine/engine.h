@@ -8,19 +8,28 @@
 
 #include "css/style_sheet.h"
 #include "dom/dom.h"
+#include "dom/mutation_log.h"
+#include "layout/box_index.h"
 #include "layout/layout.h"
 #include "layout/layout_box.h"
+#include "layout/text_measurement_cache.h"
 #include "protocol/iprotocol_handler.h"
 #include "protocol/response.h"
+#include "style/inline_style_cache.h"
+#include "style/rule_set.h"
+#include "style/style.h"
 #include "style/styled_node.h"
 #include "type/naive.h"
 #include "type/type.h"
 #include "uri/uri.h"
 
+#include <cstddef>
 #include <expected>
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
 #include <string_view>
 #include <utility>
 
@@ -39,8 +48,23 @@ struct PageState {
     protocol::Response response{};
     dom::Document dom{};
     css::StyleSheet stylesheet{};
+    // The number of rules at the start of `stylesheet` that come from the
+    // browser's built-in stylesheet.
+    std::size_t user_agent_rules{};
+    // Points into `stylesheet`, so it must be rebuilt if that's modified.
+    std::optional<style::RuleSet> rule_set;
+    style::InlineStyleCache inline_styles;
+    // Elements should be modified through this so that restyle() knows what
+    // has to be restyled.
+    dom::MutationLog mutations;
     std::unique_ptr<style::StyledNode> styled;
+    // For restyling only what's changed w/o looking through all of `styled`.
+    // Kept up to date w/ `styled` by the engine.
+    style::StyledElements styled_elements;
     std::optional<layout::LayoutBox> layout;
+    // For finding the boxes at a position or on the screen w/o looking at all
+    // of them. Kept up to date w/ `layout` by the engine.
+    std::optional<layout::BoxIndex> box_index;
     int layout_width{};
     int viewport_height{};
 };
@@ -65,6 +89,15 @@ public:
 
     void relayout(PageState &, Options);
 
+    // Restyles what's affected by the changes in the page's mutation log and
+    // lays out the page again. If the options differ from the ones last used
+    // for the page, relayout() must be used instead.
+    void restyle(PageState &, Options);
+
+    // Lays out the elements using any of the resources at `urls` again after
+    // they've finished loading, e.g. so that images get their size.
+    void resources_loaded(PageState &, Options, std::span<std::string const> urls);
+
     struct [[nodiscard]] LoadResult {
         std::expected<protocol::Response, protocol::Error> response;
         uri::Uri uri_after_redirects;
@@ -77,6 +110,8 @@ private:
     std::unique_ptr<protocol::IProtocolHandler> protocol_handler_;
     std::unique_ptr<type::IType> type_;
     std::function<std::optional<layout::Size>(std::string_view)> get_intrensic_size_for_resource_at_url_;
+    // Shared between pages as they're all using the same fonts.
+    layout::TextMeasurementCache text_measurements_;
 };
 
 } // namespace engine
@@ -9,7 +9,9 @@
 #include "dom/dom.h"
 #include "dom/xpath.h"
 #include "etest/etest2.h"
+#include "geom/geom.h"
 #include "gfx/color.h"
+#include "layout/layout_box.h"
 #include "protocol/iprotocol_handler.h"
 #include "protocol/response.h"
 #include "style/styled_node.h"
@@ -20,8 +22,10 @@
 #include <algorithm>
 #include <array>
 #include <expected>
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -152,6 +156,78 @@ int main() {
         a.expect_eq(p->get_property<css::PropertyId::Color>(), gfx::Color::from_css_name("cyan"));
     });
 
+    s.add_test("page css beats more specific browser built-in css", [](etest::IActions &a) {
+        Responses responses{{
+                "hax://example.com"s,
+                Response{
+                        .status_line = {.status_code = 200},
+                        .body{"<html><head><style>a { color: red; }</style></head><body><a href=hi>hi</a></body></html>"},
+                },
+        }};
+        engine::Engine e{std::make_unique<FakeProtocolHandler>(std::move(responses))};
+        auto page = e.navigate(uri::Uri::parse("hax://example.com").value()).value();
+
+        // Our default CSS has a :link rule setting the color.
+        auto const *link = dom::nodes_by_xpath(*page->layout, "//a"sv).at(0);
+        a.expect_eq(link->get_property<css::PropertyId::Color>(), gfx::Color::from_css_name("red"));
+    });
+
+    s.add_test("restyle after attribute changes", [](etest::IActions &a) {
+        Responses responses{{
+                "hax://example.com"s,
+                Response{
+                        .status_line = {.status_code = 200},
+                        .body{"<html><head><style>.red { color: red; }</style></head><body><p>hello</p></body></html>"},
+                },
+        }};
+        engine::Engine e{std::make_unique<FakeProtocolHandler>(std::move(responses))};
+        auto page = e.navigate(uri::Uri::parse("hax://example.com").value()).value();
+        auto const *p = dom::nodes_by_xpath(*page->layout, "//p"sv).at(0);
+        a.expect(p->get_property<css::PropertyId::Color>() != gfx::Color::from_css_name("red"));
+
+        auto &body = std::get<dom::Element>(page->dom.html().children.at(1));
+        page->mutations.set_attribute(body, "class", "red");
+        e.restyle(*page, {});
+        a.expect(page->mutations.empty());
+
+        p = dom::nodes_by_xpath(*page->layout, "//p"sv).at(0);
+        a.expect_eq(p->get_property<css::PropertyId::Color>(), gfx::Color::from_css_name("red"));
+    });
+
+    s.add_test("resources loaded", [](etest::IActions &a) {
+        Responses responses{{
+                "hax://example.com"s,
+                Response{
+                        .status_line = {.status_code = 200},
+                        .body{"<html><body><p><img src=a.png></p><p>hello</p></body></html>"},
+                },
+        }};
+        std::map<std::string, layout::Size, std::less<>> images;
+        engine::Engine e{
+                std::make_unique<FakeProtocolHandler>(std::move(responses)),
+                std::make_unique<type::NaiveType>(),
+                [&](std::string_view url) -> std::optional<layout::Size> {
+                    auto it = images.find(url);
+                    return it != images.end() ? std::optional{it->second} : std::nullopt;
+                },
+        };
+        auto page = e.navigate(uri::Uri::parse("hax://example.com").value()).value();
+        auto const *hello = dom::nodes_by_xpath(*page->layout, "//p"sv).at(1);
+        auto const hello_y = hello->dimensions.content.y;
+
+        images["a.png"] = layout::Size{100, 50};
+        std::array<std::string, 1> const loaded{"a.png"};
+        e.resources_loaded(*page, {}, loaded);
+
+        auto const *img = dom::nodes_by_xpath(*page->layout, "//img"sv).at(0);
+        a.expect_eq(img->dimensions.content.width, 100);
+        a.expect_eq(img->dimensions.content.height, 50);
+        auto img_position = geom::snapped(img->dimensions.content.position());
+        a.expect(page->box_index->box_at_position({img_position.x + 1, img_position.y + 1}) == img);
+        hello = dom::nodes_by_xpath(*page->layout, "//p"sv).at(1);
+        a.expect(hello->dimensions.content.y > hello_y);
+    });
+
     s.add_test("stylesheet link, parallel download", [](etest::IActions &a) {
         Responses responses;
         responses["hax://example.com"s] = Response{
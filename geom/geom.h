@@ -1,46 +1,68 @@
-// SPDX-FileCopyrightText: 2021-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #ifndef GEOM_GEOM_H_
 #define GEOM_GEOM_H_
 
+#include "geom/layout_unit.h"
+
 #include <algorithm>
+#include <concepts>
 
 namespace geom {
 
-struct Position {
-    int x{}, y{};
-    [[nodiscard]] bool operator==(Position const &) const = default;
+// These work w/ both whole pixels and LayoutUnits. Geometry in whole pixels
+// converts to LayoutUnits w/ a static_cast, and LayoutUnits are rounded to
+// whole pixels w/ snapped.
+
+template<typename T>
+struct BasicPosition {
+    T x{}, y{};
+    [[nodiscard]] bool operator==(BasicPosition const &) const = default;
 
-    [[nodiscard]] constexpr Position scaled(unsigned scale, Position origin = {0, 0}) const {
-        return Position{
+    [[nodiscard]] constexpr BasicPosition scaled(unsigned scale, BasicPosition origin = {}) const {
+        return BasicPosition{
                 origin.x + (x - origin.x) * static_cast<int>(scale),
                 origin.y + (y - origin.y) * static_cast<int>(scale),
         };
     }
 
-    [[nodiscard]] constexpr Position translated(int dx, int dy) const { return {x + dx, y + dy}; }
+    [[nodiscard]] constexpr BasicPosition translated(T dx, T dy) const { return {x + dx, y + dy}; }
+
+    template<typename U>
+    requires(!std::same_as<T, U> && std::convertible_to<T, U>)
+    [[nodiscard]] explicit constexpr operator BasicPosition<U>() const {
+        return {x, y};
+    }
 };
 
-struct EdgeSize {
-    int left{}, right{}, top{}, bottom{};
-    [[nodiscard]] bool operator==(EdgeSize const &) const = default;
+template<typename T>
+struct BasicEdgeSize {
+    T left{}, right{}, top{}, bottom{};
+    [[nodiscard]] bool operator==(BasicEdgeSize const &) const = default;
+
+    template<typename U>
+    requires(!std::same_as<T, U> && std::convertible_to<T, U>)
+    [[nodiscard]] explicit constexpr operator BasicEdgeSize<U>() const {
+        return {left, right, top, bottom};
+    }
 };
 
-struct Rect {
-    int x{}, y{}, width{}, height{};
-    [[nodiscard]] bool operator==(Rect const &) const = default;
+template<typename T>
+struct BasicRect {
+    T x{}, y{}, width{}, height{};
+    [[nodiscard]] bool operator==(BasicRect const &) const = default;
 
-    [[nodiscard]] constexpr int left() const { return x; }
-    [[nodiscard]] constexpr int right() const { return x + width; }
-    [[nodiscard]] constexpr int top() const { return y; }
-    [[nodiscard]] constexpr int bottom() const { return y + height; }
+    [[nodiscard]] constexpr T left() const { return x; }
+    [[nodiscard]] constexpr T right() const { return x + width; }
+    [[nodiscard]] constexpr T top() const { return y; }
+    [[nodiscard]] constexpr T bottom() const { return y + height; }
 
-    [[nodiscard]] constexpr Position position() const { return {x, y}; }
+    [[nodiscard]] constexpr BasicPosition<T> position() const { return {x, y}; }
 
-    [[nodiscard]] constexpr Rect expanded(EdgeSize const &edges) const {
-        return Rect{
+    [[nodiscard]] constexpr BasicRect expanded(BasicEdgeSize<T> const &edges) const {
+        return BasicRect{
                 left() - edges.left,
                 top() - edges.top,
                 edges.left + width + edges.right,
@@ -48,18 +70,18 @@ struct Rect {
         };
     }
 
-    [[nodiscard]] constexpr Rect scaled(unsigned scale, Position origin = {0, 0}) const {
-        return Rect{
+    [[nodiscard]] constexpr BasicRect scaled(unsigned scale, BasicPosition<T> origin = {}) const {
+        return BasicRect{
                 origin.x + (x - origin.x) * static_cast<int>(scale),
                 origin.y + (y - origin.y) * static_cast<int>(scale),
-                static_cast<int>(width * scale),
-                static_cast<int>(height * scale),
+                width * static_cast<int>(scale),
+                height * static_cast<int>(scale),
         };
     }
 
-    [[nodiscard]] constexpr Rect translated(int dx, int dy) const { return {x + dx, y + dy, width, height}; }
+    [[nodiscard]] constexpr BasicRect translated(T dx, T dy) const { return {x + dx, y + dy, width, height}; }
 
-    [[nodiscard]] constexpr Rect intersected(Rect const &other) const {
+    [[nodiscard]] constexpr BasicRect intersected(BasicRect const &other) const {
         auto new_left = std::max(left(), other.left());
         auto new_right = std::min(right(), other.right());
         auto new_top = std::max(top(), other.top());
@@ -68,7 +90,7 @@ struct Rect {
             return {};
         }
 
-        return Rect{
+        return BasicRect{
                 new_left,
                 new_top,
                 new_right - new_left,
@@ -76,15 +98,45 @@ struct Rect {
         };
     }
 
-    [[nodiscard]] constexpr bool contains(Position const &p) const {
+    [[nodiscard]] constexpr bool contains(BasicPosition<T> const &p) const {
         bool inside_horizontally = p.x >= left() && p.x <= right();
         bool inside_vertically = p.y >= top() && p.y <= bottom();
         return inside_vertically && inside_horizontally;
     }
 
-    [[nodiscard]] constexpr bool empty() const { return width <= 0 || height <= 0; }
+    [[nodiscard]] constexpr bool empty() const { return width <= T{} || height <= T{}; }
+
+    template<typename U>
+    requires(!std::same_as<T, U> && std::convertible_to<T, U>)
+    [[nodiscard]] explicit constexpr operator BasicRect<U>() const {
+        return {x, y, width, height};
+    }
 };
 
+using Position = BasicPosition<int>;
+using EdgeSize = BasicEdgeSize<int>;
+using Rect = BasicRect<int>;
+
+using LayoutPosition = BasicPosition<LayoutUnit>;
+using LayoutEdgeSize = BasicEdgeSize<LayoutUnit>;
+using LayoutRect = BasicRect<LayoutUnit>;
+
+[[nodiscard]] constexpr Position snapped(LayoutPosition const &p) {
+    return {p.x.round(), p.y.round()};
+}
+
+// The edges are rounded rather than the size, so that rects sharing an edge
+// still do once snapped.
+[[nodiscard]] constexpr Rect snapped(LayoutRect const &r) {
+    auto const left = r.left().round();
+    auto const top = r.top().round();
+    return {left, top, r.right().round() - left, r.bottom().round() - top};
+}
+
+[[nodiscard]] constexpr EdgeSize snapped(LayoutEdgeSize const &e) {
+    return {e.left.round(), e.right.round(), e.top.round(), e.bottom.round()};
+}
+
 } // namespace geom
 
 #endif
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -7,6 +7,8 @@
 #include "etest/etest2.h"
 
 using geom::EdgeSize;
+using geom::LayoutRect;
+using geom::LayoutUnit;
 using geom::Position;
 using geom::Rect;
 
@@ -133,5 +135,39 @@ int main() {
         a.expect(!Rect{0, 0, 1, 1}.empty());
     });
 
+    s.add_test("LayoutRect", [](etest::IActions &a) {
+        auto const half = LayoutUnit::from_raw(LayoutUnit::kSubpixels / 2);
+        LayoutRect r{half, 0, 10, 10};
+        a.expect_eq(r.right(), LayoutUnit{10} + half);
+        a.expect_eq(r.expanded({half, half, 0, 0}), LayoutRect{0, 0, 11, 10});
+        a.expect(r.contains({10, 10}));
+        a.expect(!r.contains({0, 10}));
+
+        a.expect_eq(static_cast<LayoutRect>(Rect{1, 2, 3, 4}), LayoutRect{1, 2, 3, 4});
+    });
+
+    s.add_test("snapped", [](etest::IActions &a) {
+        auto const px = [](float f) { return LayoutUnit::from_float(f); };
+        a.expect_eq(geom::snapped(LayoutRect{1, 2, 3, 4}), Rect{1, 2, 3, 4});
+        a.expect_eq(geom::snapped(geom::LayoutPosition{px(1.4f), px(1.5f)}), Position{1, 2});
+
+        // Rects next to each other stay next to each other.
+        LayoutRect left{px(0.3f), 0, px(10.4f), px(2.5f)};
+        LayoutRect right{left.right(), 0, px(10.4f), px(2.5f)};
+        a.expect_eq(geom::snapped(left), Rect{0, 0, 11, 3});
+        a.expect_eq(geom::snapped(right), Rect{11, 0, 10, 3});
+
+        a.expect_eq(geom::snapped(geom::LayoutEdgeSize{px(0.5f), px(0.4f), 1, px(-0.6f)}), EdgeSize{1, 0, 1, -1});
+
+        // Saturated widths and edges.
+        auto const max = LayoutUnit::max();
+        auto const min = LayoutUnit::min();
+        a.expect_eq(geom::snapped(LayoutRect{0, 0, max, max}), Rect{0, 0, 33'554'432, 33'554'432});
+        a.expect_eq(geom::snapped(LayoutRect{10'000'000, 0, max, 1}), Rect{10'000'000, 0, 23'554'432, 1});
+        a.expect_eq(geom::snapped(LayoutRect{min, min, max, max}),
+                Rect{-33'554'432, -33'554'432, 33'554'432, 33'554'432});
+        a.expect_eq(geom::snapped(geom::LayoutPosition{max, min}), Position{33'554'432, -33'554'432});
+    });
+
     return s.run();
 }
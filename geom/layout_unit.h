@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef GEOM_LAYOUT_UNIT_H_
+#define GEOM_LAYOUT_UNIT_H_
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <limits>
+
+namespace geom {
+
+// A length in 1/64ths of a pixel. Layout works in these so that fractions of
+// pixels add up exactly, and the same way on every platform, instead of every
+// step rounding to whole pixels. Whatever is drawn is rounded to whole pixels
+// only once it's known how it'll be scaled.
+//
+// Lengths outside of what fits, about +-33 million pixels, are clamped, and
+// all arithmetic saturates instead of overflowing, so huge lengths in a page
+// end up as the largest ones possible instead of wrapping around.
+class LayoutUnit {
+public:
+    static constexpr int kFractionalBits = 6;
+    static constexpr int kSubpixels = 1 << kFractionalBits;
+
+    constexpr LayoutUnit() = default;
+    // Whole pixels are always exact, so they're converted implicitly.
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    constexpr LayoutUnit(int px) : raw_{saturate(std::int64_t{px} * kSubpixels)} {}
+
+    [[nodiscard]] static constexpr LayoutUnit max() { return from_raw(std::numeric_limits<int>::max()); }
+    [[nodiscard]] static constexpr LayoutUnit min() { return from_raw(std::numeric_limits<int>::min()); }
+
+    [[nodiscard]] static constexpr LayoutUnit from_raw(int raw) {
+        LayoutUnit unit;
+        unit.raw_ = raw;
+        return unit;
+    }
+
+    // Rounded to the closest subpixel, w/ halves rounded away from zero. NaN
+    // becomes 0.
+    [[nodiscard]] static constexpr LayoutUnit from_float(float px) {
+        // Every int fits in a double, and the float's exponent is too small
+        // for this to reach infinity.
+        auto const subpixels = static_cast<double>(px) * kSubpixels;
+        if (subpixels != subpixels) {
+            return {};
+        }
+
+        if (subpixels >= std::numeric_limits<int>::max()) {
+            return max();
+        }
+
+        if (subpixels <= std::numeric_limits<int>::min()) {
+            return min();
+        }
+
+        return from_raw(static_cast<int>(subpixels < 0 ? subpixels - 0.5 : subpixels + 0.5));
+    }
+
+    [[nodiscard]] constexpr int raw() const { return raw_; }
+    [[nodiscard]] constexpr float to_float() const { return static_cast<float>(raw_) / kSubpixels; }
+
+    // Done in 64 bits so that they can't overflow next to max() and min().
+    [[nodiscard]] constexpr int floor() const { return saturate(std::int64_t{raw_} >> kFractionalBits); }
+    [[nodiscard]] constexpr int ceil() const { return saturate(-(-std::int64_t{raw_} >> kFractionalBits)); }
+    // Halves are rounded up, so that two lengths a whole number of pixels
+    // apart are still that far apart once rounded.
+    [[nodiscard]] constexpr int round() const {
+        return saturate((std::int64_t{raw_} + kSubpixels / 2) >> kFractionalBits);
+    }
+
+    [[nodiscard]] constexpr bool operator==(LayoutUnit const &) const = default;
+    [[nodiscard]] constexpr auto operator<=>(LayoutUnit const &) const = default;
+
+    constexpr LayoutUnit &operator+=(LayoutUnit other) {
+        raw_ = saturate(std::int64_t{raw_} + other.raw_);
+        return *this;
+    }
+
+    constexpr LayoutUnit &operator-=(LayoutUnit other) {
+        raw_ = saturate(std::int64_t{raw_} - other.raw_);
+        return *this;
+    }
+
+    constexpr LayoutUnit &operator*=(int factor) {
+        raw_ = saturate(std::int64_t{raw_} * factor);
+        return *this;
+    }
+
+    // Rounds towards zero, like integer division.
+    constexpr LayoutUnit &operator/=(int divisor) {
+        raw_ = saturate(std::int64_t{raw_} / divisor);
+        return *this;
+    }
+
+    [[nodiscard]] friend constexpr LayoutUnit operator+(LayoutUnit a, LayoutUnit b) { return a += b; }
+    [[nodiscard]] friend constexpr LayoutUnit operator-(LayoutUnit a, LayoutUnit b) { return a -= b; }
+    [[nodiscard]] friend constexpr LayoutUnit operator-(LayoutUnit a) { return LayoutUnit{} -= a; }
+    [[nodiscard]] friend constexpr LayoutUnit operator*(LayoutUnit a, int factor) { return a *= factor; }
+    [[nodiscard]] friend constexpr LayoutUnit operator*(int factor, LayoutUnit a) { return a *= factor; }
+    [[nodiscard]] friend constexpr LayoutUnit operator/(LayoutUnit a, int divisor) { return a /= divisor; }
+
+private:
+    [[nodiscard]] static constexpr int saturate(std::int64_t v) {
+        return static_cast<int>(
+                std::clamp<std::int64_t>(v, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()));
+    }
+
+    int raw_{};
+};
+
+} // namespace geom
+
+#endif
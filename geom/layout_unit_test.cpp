@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "geom/layout_unit.h"
+
+#include "etest/etest2.h"
+
+#include <limits>
+
+using geom::LayoutUnit;
+
+int main() {
+    etest::Suite s{};
+
+    s.add_test("whole pixels", [](etest::IActions &a) {
+        a.expect_eq(LayoutUnit{}.raw(), 0);
+        a.expect_eq(LayoutUnit{3}.raw(), 3 * LayoutUnit::kSubpixels);
+        a.expect_eq(LayoutUnit{-3}.raw(), -3 * LayoutUnit::kSubpixels);
+        a.expect_eq(LayoutUnit{3}.floor(), 3);
+        a.expect_eq(LayoutUnit{3}.ceil(), 3);
+        a.expect_eq(LayoutUnit{3}.round(), 3);
+        a.expect_eq(LayoutUnit{-3}.round(), -3);
+        a.expect_eq(LayoutUnit{3}.to_float(), 3.f);
+    });
+
+    s.add_test("from_float", [](etest::IActions &a) {
+        a.expect_eq(LayoutUnit::from_float(1.5f).raw(), 96);
+        a.expect_eq(LayoutUnit::from_float(-1.5f).raw(), -96);
+        // 0.3 * 64 = 19.2
+        a.expect_eq(LayoutUnit::from_float(0.3f).raw(), 19);
+        // 0.3046875 * 64 = 19.5
+        a.expect_eq(LayoutUnit::from_float(0.3046875f).raw(), 20);
+        a.expect_eq(LayoutUnit::from_float(-0.3046875f).raw(), -20);
+        a.expect_eq(LayoutUnit::from_float(0.25f).to_float(), 0.25f);
+    });
+
+    s.add_test("rounding to whole pixels", [](etest::IActions &a) {
+        auto const px = [](float f) { return LayoutUnit::from_float(f); };
+        a.expect_eq(px(1.25f).floor(), 1);
+        a.expect_eq(px(1.25f).ceil(), 2);
+        a.expect_eq(px(1.25f).round(), 1);
+        a.expect_eq(px(1.5f).round(), 2);
+        a.expect_eq(px(1.75f).round(), 2);
+
+        a.expect_eq(px(-1.25f).floor(), -2);
+        a.expect_eq(px(-1.25f).ceil(), -1);
+        a.expect_eq(px(-1.25f).round(), -1);
+        a.expect_eq(px(-1.5f).round(), -1);
+        a.expect_eq(px(-1.75f).round(), -2);
+    });
+
+    s.add_test("arithmetic", [](etest::IActions &a) {
+        auto const third = LayoutUnit::from_float(1.f / 3);
+        a.expect_eq(third.raw(), 21);
+        a.expect_eq((third + third + third).raw(), 63);
+        a.expect_eq((third * 3).raw(), 63);
+        a.expect_eq((3 * third).raw(), 63);
+        a.expect_eq((LayoutUnit{1} - third).raw(), 43);
+        a.expect_eq((-third).raw(), -21);
+        a.expect_eq((LayoutUnit{1} / 3).raw(), 21);
+        a.expect_eq((LayoutUnit{-1} / 3).raw(), -21);
+
+        // Whole pixels mix w/ LayoutUnits.
+        a.expect_eq(third + 1, LayoutUnit::from_raw(85));
+        a.expect(third < 1);
+        a.expect(1 > third);
+        a.expect(LayoutUnit{2} == 2);
+    });
+
+    s.add_test("huge lengths", [](etest::IActions &a) {
+        auto const max = LayoutUnit::max();
+        auto const min = LayoutUnit::min();
+        a.expect_eq(max.floor(), 33'554'431);
+        a.expect_eq(min.floor(), -33'554'432);
+        a.expect_eq(max.ceil(), 33'554'432);
+        a.expect_eq(min.ceil(), -33'554'432);
+        a.expect_eq(max.round(), 33'554'432);
+        a.expect_eq(min.round(), -33'554'432);
+
+        a.expect_eq(LayoutUnit::from_float(1e8f), max);
+        a.expect_eq(LayoutUnit::from_float(-1e8f), min);
+        a.expect_eq(LayoutUnit::from_float(std::numeric_limits<float>::infinity()), max);
+        a.expect_eq(LayoutUnit::from_float(-std::numeric_limits<float>::infinity()), min);
+        a.expect_eq(LayoutUnit::from_float(std::numeric_limits<float>::quiet_NaN()), LayoutUnit{});
+        a.expect_eq(LayoutUnit{100'000'000}, max);
+        a.expect_eq(LayoutUnit{-100'000'000}, min);
+        a.expect_eq(LayoutUnit{std::numeric_limits<int>::min()}, min);
+
+        // Saturates instead of wrapping around.
+        a.expect_eq(max + 1, max);
+        a.expect_eq(max + max, max);
+        a.expect_eq(min - 1, min);
+        a.expect_eq(1 - min, max);
+        a.expect_eq(-min, max);
+        a.expect_eq(-max, min + LayoutUnit::from_raw(1));
+        a.expect_eq(max * 2, max);
+        a.expect_eq(max * -2, min);
+        a.expect_eq(min / -1, max);
+
+        // Lengths that fit still add up exactly.
+        auto const big = LayoutUnit::from_float(1e7f);
+        a.expect_eq((big + big + big).floor(), 30'000'000);
+        a.expect_eq(big * 4 - big, max - big);
+    });
+
+    s.add_test("constexpr", [](etest::IActions &a) {
+        static constexpr auto kUnit = LayoutUnit::from_float(2.5f) * 2 - 1;
+        static_assert(kUnit == 4);
+        a.expect_eq(kUnit.round(), 4);
+    });
+
+    return s.run();
+}
@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "layout/box_index.h"
+
+#include "layout/layout_box.h"
+
+#include "geom/geom.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace layout {
+
+BoxIndex::BoxIndex(LayoutBox const &root) {
+    add(root, 0);
+
+    by_top_.resize(entries_.size());
+    std::iota(by_top_.begin(), by_top_.end(), std::size_t{0});
+    std::ranges::stable_sort(by_top_, {}, [this](std::size_t i) { return entries_[i].border_box.top(); });
+
+    max_bottom_.resize(4 * by_top_.size());
+    build_max_bottom(1, 0, by_top_.size());
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void BoxIndex::add(LayoutBox const &box, std::size_t parent) {
+    auto const index = entries_.size();
+    entries_.push_back({.box = &box, .border_box = box.dimensions.border_box(), .parent = parent});
+    for (auto const &child : box.children) {
+        add(child, index);
+    }
+
+    entries_[index].subtree_end = entries_.size();
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+geom::LayoutUnit BoxIndex::build_max_bottom(std::size_t node, std::size_t first, std::size_t last) {
+    if (last - first == 1) {
+        return max_bottom_[node] = entries_[by_top_[first]].border_box.bottom();
+    }
+
+    auto const mid = first + (last - first) / 2;
+    auto const left = build_max_bottom(2 * node, first, mid);
+    auto const right = build_max_bottom(2 * node + 1, mid, last);
+    return max_bottom_[node] = std::max(left, right);
+}
+
+template<typename TopOk, typename BottomOk>
+std::vector<std::size_t> BoxIndex::overlapping(TopOk const &top_ok, BottomOk const &bottom_ok) const {
+    auto const end = std::ranges::partition_point(
+            by_top_, [&](std::size_t i) { return top_ok(entries_[i].border_box.top()); });
+    std::vector<std::size_t> found;
+    overlapping(1, 0, by_top_.size(), static_cast<std::size_t>(end - by_top_.begin()), bottom_ok, found);
+    std::ranges::sort(found);
+    return found;
+}
+
+template<typename BottomOk>
+// NOLINTNEXTLINE(misc-no-recursion)
+void BoxIndex::overlapping(std::size_t node,
+        std::size_t first,
+        std::size_t last,
+        std::size_t end,
+        BottomOk const &bottom_ok,
+        std::vector<std::size_t> &found) const {
+    if (first >= end || !bottom_ok(max_bottom_[node])) {
+        return;
+    }
+
+    if (last - first == 1) {
+        found.push_back(by_top_[first]);
+        return;
+    }
+
+    auto const mid = first + (last - first) / 2;
+    overlapping(2 * node, first, mid, end, bottom_ok, found);
+    overlapping(2 * node + 1, mid, last, end, bottom_ok, found);
+}
+
+void BoxIndex::remove_orphans(std::vector<std::size_t> &found) const {
+    // Parents come before their children, so everything before an entry has
+    // already been checked when it's looked at.
+    std::vector<std::size_t> kept;
+    kept.reserve(found.size());
+    for (auto i : found) {
+        if (i == 0 || std::ranges::binary_search(kept, entries_[i].parent)) {
+            kept.push_back(i);
+        }
+    }
+
+    found = std::move(kept);
+}
+
+LayoutBox const *BoxIndex::box_at_position(geom::Position position) const {
+    auto const p = static_cast<geom::LayoutPosition>(position);
+    auto hits = overlapping([&](geom::LayoutUnit top) { return top <= p.y; },
+            [&](geom::LayoutUnit bottom) { return bottom >= p.y; });
+    std::erase_if(hits, [&](std::size_t i) { return !entries_[i].border_box.contains(p); });
+    remove_orphans(hits);
+    if (hits.empty()) {
+        return nullptr;
+    }
+
+    assert(hits.front() == 0);
+    std::size_t i = 0;
+    return first_hit(hits, i);
+}
+
+// Like box_at_position(LayoutBox const &, geom::Position), but only looking
+// at the boxes containing the position.
+// NOLINTNEXTLINE(misc-no-recursion)
+LayoutBox const *BoxIndex::first_hit(std::span<std::size_t const> hits, std::size_t &i) const {
+    auto const &entry = entries_[hits[i++]];
+    while (i < hits.size() && hits[i] < entry.subtree_end) {
+        if (auto const *found = first_hit(hits, i)) {
+            return found;
+        }
+    }
+
+    return entry.box->is_anonymous_block() ? nullptr : entry.box;
+}
+
+std::vector<LayoutBox const *> BoxIndex::boxes_in(geom::Rect const &rect) const {
+    auto const area = static_cast<geom::LayoutRect>(rect);
+    auto found = overlapping([&](geom::LayoutUnit top) { return top < area.bottom(); },
+            [&](geom::LayoutUnit bottom) { return bottom > area.top(); });
+    std::erase_if(found, [&](std::size_t i) { return area.intersected(entries_[i].border_box).empty(); });
+    remove_orphans(found);
+
+    std::vector<LayoutBox const *> boxes;
+    boxes.reserve(found.size());
+    for (auto i : found) {
+        boxes.push_back(entries_[i].box);
+    }
+
+    return boxes;
+}
+
+} // namespace layout
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef LAYOUT_BOX_INDEX_H_
+#define LAYOUT_BOX_INDEX_H_
+
+#include "layout/layout_box.h"
+
+#include "geom/geom.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace layout {
+
+// Finds the boxes at a position or in an area w/o visiting every box in the
+// layout. The results are the same as those of box_at_position and of
+// walking the tree skipping any box whose border box is outside of the area,
+// but only the boxes overlapping the area vertically are looked at.
+//
+// This points into the layout, so it has to be rebuilt whenever that changes.
+class BoxIndex {
+public:
+    explicit BoxIndex(LayoutBox const &root);
+
+    LayoutBox const *box_at_position(geom::Position) const;
+
+    // The boxes whose border box, and the border boxes of all of their
+    // ancestors, overlap the area, in tree order.
+    std::vector<LayoutBox const *> boxes_in(geom::Rect const &) const;
+
+private:
+    struct Entry {
+        LayoutBox const *box{};
+        geom::LayoutRect border_box;
+        // Index of the parent, or the entry itself for the root.
+        std::size_t parent{};
+        // Index of the first entry after this box's descendants.
+        std::size_t subtree_end{};
+    };
+
+    // In tree order.
+    std::vector<Entry> entries_;
+    // Indices into entries_ sorted by the top of their border box.
+    std::vector<std::size_t> by_top_;
+    // A segment tree over by_top_ holding the largest bottom in each range.
+    std::vector<geom::LayoutUnit> max_bottom_;
+
+    void add(LayoutBox const &, std::size_t parent);
+    geom::LayoutUnit build_max_bottom(std::size_t node, std::size_t first, std::size_t last);
+
+    // The entries whose border box passes both checks, in tree order.
+    // top_ok must hold for every top up to some value, and bottom_ok for
+    // every bottom from some value on.
+    template<typename TopOk, typename BottomOk>
+    std::vector<std::size_t> overlapping(TopOk const &, BottomOk const &) const;
+    template<typename BottomOk>
+    void overlapping(std::size_t node,
+            std::size_t first,
+            std::size_t last,
+            std::size_t end,
+            BottomOk const &,
+            std::vector<std::size_t> &found) const;
+    // Removes the entries whose parent isn't in the list.
+    void remove_orphans(std::vector<std::size_t> &) const;
+    LayoutBox const *first_hit(std::span<std::size_t const> hits, std::size_t &i) const;
+};
+
+} // namespace layout
+
+#endif
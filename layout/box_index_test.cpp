@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "layout/box_index.h"
+
+#include "layout/layout.h"
+#include "layout/layout_box.h"
+
+#include "css/property_id.h"
+#include "dom/dom.h"
+#include "etest/etest2.h"
+#include "geom/geom.h"
+#include "style/styled_node.h"
+
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+void set_up_parent_ptrs(style::StyledNode &root) {
+    std::vector<style::StyledNode *> stack{&root};
+    while (!stack.empty()) {
+        auto *node = stack.back();
+        stack.pop_back();
+        for (auto &child : node->children) {
+            child.parent = node;
+            stack.push_back(&child);
+        }
+    }
+}
+
+// What render does w/o an index.
+// NOLINTNEXTLINE(misc-no-recursion)
+void boxes_in(layout::LayoutBox const &box,
+        geom::LayoutRect const &area,
+        std::vector<layout::LayoutBox const *> &found) {
+    if (area.intersected(box.dimensions.border_box()).empty()) {
+        return;
+    }
+
+    found.push_back(&box);
+    for (auto const &child : box.children) {
+        boxes_in(child, area, found);
+    }
+}
+
+} // namespace
+
+int main() {
+    etest::Suite s{};
+
+    s.add_test("box_at_position", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{"dummy"};
+        style::StyledNode style{dom, {{css::PropertyId::Display, "block"}}};
+        std::vector<layout::LayoutBox> children{
+                {nullptr, {{30, 30, 5, 5}}, {}},
+                {&style, {{45, 45, 5, 5}}, {}},
+                // Outside of its parent, so it can't be found.
+                {&style, {{80, 80, 5, 5}}, {}},
+        };
+
+        auto layout = layout::LayoutBox{
+                .node = &style,
+                .dimensions = {{0, 0, 100, 100}},
+                .children{
+                        {&style, {{25, 25, 50, 50}}, {std::move(children)}},
+                },
+        };
+        layout::BoxIndex const index{layout};
+
+        a.expect(index.box_at_position({-1, -1}) == nullptr);
+        a.expect(index.box_at_position({101, 101}) == nullptr);
+
+        a.expect(index.box_at_position({100, 100}) == &layout);
+        a.expect(index.box_at_position({0, 0}) == &layout);
+
+        // We don't want to end up in anonymous blocks, so this should return its parent.
+        a.expect(index.box_at_position({31, 31}) == &layout.children[0]);
+
+        a.expect(index.box_at_position({75, 75}) == &layout.children[0]);
+        a.expect(index.box_at_position({47, 47}) == &layout.children[0].children[1]);
+        a.expect(index.box_at_position({82, 82}) == &layout);
+    });
+
+    s.add_test("boxes_in", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{"dummy"};
+        style::StyledNode style{dom, {{css::PropertyId::Display, "block"}}};
+        std::vector<layout::LayoutBox> children{
+                {&style, {{0, 0, 100, 10}}, {}},
+                {&style, {{0, 10, 100, 10}}, {}},
+                // Empty boxes are never visible.
+                {&style, {{0, 20, 100, 0}}, {}},
+                {&style, {{0, 20, 100, 10}}, {}},
+        };
+        auto layout = layout::LayoutBox{
+                .node = &style,
+                .dimensions = {{0, 0, 100, 30}},
+                .children = std::move(children),
+        };
+        layout::BoxIndex const index{layout};
+
+        using Boxes = std::vector<layout::LayoutBox const *>;
+        auto const &c = layout.children;
+        a.expect(index.boxes_in({0, 0, 100, 30}) == Boxes{&layout, &c[0], &c[1], &c[3]});
+        a.expect(index.boxes_in({0, 10, 100, 10}) == Boxes{&layout, &c[1]});
+        a.expect(index.boxes_in({0, 15, 100, 10}) == Boxes{&layout, &c[1], &c[3]});
+        a.expect(index.boxes_in({0, 30, 100, 10}).empty());
+        a.expect(index.boxes_in({0, 0, 0, 0}).empty());
+    });
+
+    s.add_test("same results as walking the tree", [](etest::IActions &a) {
+        dom::Element body{"body"};
+        for (int i = 0; i < 50; ++i) {
+            body.children.emplace_back(dom::Element{"p", {}, {dom::Text{std::string(i % 7 * 10 + 1, 'a') + " b c"}}});
+        }
+        dom::Node dom = dom::Element{"html", {}, {std::move(body)}};
+
+        auto const &body_node = std::get<dom::Element>(dom).children[0];
+        style::StyledNode styled{
+                .node{dom},
+                .properties{{css::PropertyId::Display, "block"}, {css::PropertyId::FontSize, "10px"}},
+                .children{{body_node, {{css::PropertyId::Display, "block"}, {css::PropertyId::PaddingLeft, "5px"}}}},
+        };
+        for (auto const &p : std::get<dom::Element>(body_node).children) {
+            auto &styled_p = styled.children[0].children.emplace_back(
+                    style::StyledNode{p, {{css::PropertyId::Display, "block"}}});
+            styled_p.children.push_back({std::get<dom::Element>(p).children[0]});
+        }
+        set_up_parent_ptrs(styled);
+
+        auto layout = layout::create_layout(styled, {.viewport_width = 100}).value();
+        layout::BoxIndex const index{layout};
+
+        for (int y = -5; y < layout.dimensions.content.height + 5; y += 3) {
+            for (int x = -5; x < 105; x += 4) {
+                a.expect(index.box_at_position({x, y}) == layout::box_at_position(layout, {x, y}));
+            }
+
+            std::vector<layout::LayoutBox const *> expected;
+            boxes_in(layout, {y % 50, y, 40, 25}, expected);
+            a.expect(index.boxes_in({y % 50, y, 40, 25}) == expected);
+        }
+    });
+
+    return s.run();
+}
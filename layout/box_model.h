@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -9,20 +9,23 @@
 
 namespace layout {
 
+// In LayoutUnits, so that nothing is rounded to whole pixels until it's drawn.
 struct BoxModel {
-    geom::Rect content{};
+    geom::LayoutRect content{};
 
-    geom::EdgeSize padding{};
-    geom::EdgeSize border{};
-    geom::EdgeSize margin{};
+    geom::LayoutEdgeSize padding{};
+    geom::LayoutEdgeSize border{};
+    geom::LayoutEdgeSize margin{};
 
     [[nodiscard]] bool operator==(BoxModel const &) const = default;
 
-    constexpr geom::Rect padding_box() const { return content.expanded(padding); }
-    constexpr geom::Rect border_box() const { return padding_box().expanded(border); }
-    constexpr geom::Rect margin_box() const { return border_box().expanded(margin); }
+    constexpr geom::LayoutRect padding_box() const { return content.expanded(padding); }
+    constexpr geom::LayoutRect border_box() const { return padding_box().expanded(border); }
+    constexpr geom::LayoutRect margin_box() const { return border_box().expanded(margin); }
 
-    constexpr bool contains(geom::Position p) const { return border_box().contains(p); }
+    constexpr bool contains(geom::Position p) const {
+        return border_box().contains(static_cast<geom::LayoutPosition>(p));
+    }
 };
 
 } // namespace layout
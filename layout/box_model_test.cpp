@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -18,9 +18,9 @@ int main() {
                 .margin{.left = 100, .right = 100, .top = 100, .bottom = 100}, // x: 100-800, y: 100-800
         };
 
-        a.expect(box.padding_box() == geom::Rect{300, 300, 300, 300});
-        a.expect(box.border_box() == geom::Rect{200, 200, 500, 500});
-        a.expect(box.margin_box() == geom::Rect{100, 100, 700, 700});
+        a.expect(box.padding_box() == geom::LayoutRect{300, 300, 300, 300});
+        a.expect(box.border_box() == geom::LayoutRect{200, 200, 500, 500});
+        a.expect(box.margin_box() == geom::LayoutRect{100, 100, 700, 700});
     });
 
     s.add_test("BoxModel box models", [](etest::IActions &a) {
@@ -38,5 +38,17 @@ int main() {
         a.expect(!box.contains({90, 90})); // Outside margin.
     });
 
+    s.add_test("BoxModel fractions of pixels", [](etest::IActions &a) {
+        auto const half = geom::LayoutUnit::from_float(0.5f);
+        layout::BoxModel box{
+                .content{.x = half, .y = 0, .width = 10, .height = 10},
+                .padding{.left = half, .right = half},
+        };
+
+        a.expect_eq(box.padding_box(), geom::LayoutRect{0, 0, 11, 10});
+        a.expect(box.contains({11, 0}));
+        a.expect(!box.contains({12, 0}));
+    });
+
     return s.run();
 }
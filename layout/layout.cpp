@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -6,6 +6,7 @@
 #include "layout/layout.h"
 
 #include "layout/layout_box.h"
+#include "layout/text_measurement_cache.h"
 
 #include "css/property_id.h"
 #include "dom/dom.h"
@@ -19,17 +20,22 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <functional>
+#include <future>
 #include <iterator>
-#include <list>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <ranges>
+#include <set>
 #include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -39,89 +45,148 @@ using namespace std::literals;
 namespace layout {
 namespace {
 
+// Text that's no longer on the page stays in the cache, so it's emptied every
+// now and then instead of growing forever.
+constexpr std::size_t kMaxCachedTextMeasurements = 100'000;
+
+// The nodes that have to be laid out again in a relayout.
+struct DirtyNodes {
+    std::set<style::StyledNode const *> dirty;
+    // The dirty nodes and all of their ancestors.
+    std::set<style::StyledNode const *> affected;
+};
+
+// Where a lazy layout stopped, as the indices of the children to continue w/,
+// from the innermost box out. Every box on the way there is partially laid out.
+struct LazyStop {
+    // Blocks starting below this aren't laid out.
+    int below{};
+    std::vector<std::size_t> path;
+};
+
+// Runs of fewer nodes than this aren't worth starting a new thread for, and
+// blocks w/ fewer than twice as many are laid out on the thread getting to them.
+constexpr std::size_t kMinParallelSubtreeSize = 2048;
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::size_t count_subtree_sizes(
+        style::StyledNode const &node, std::unordered_map<style::StyledNode const *, std::size_t> &sizes) {
+    std::size_t size = 1;
+    for (auto const &child : node.children) {
+        size += count_subtree_sizes(child, sizes);
+    }
+
+    sizes.emplace(&node, size);
+    return size;
+}
+
+// Shared by all threads taking part in laying out a tree in parallel.
+class ParallelLayout {
+public:
+    ParallelLayout(std::unordered_map<style::StyledNode const *, std::size_t> subtree_sizes,
+            std::size_t max_threads,
+            TextMeasurementCache const &text_measurements)
+        : subtree_sizes_{std::move(subtree_sizes)}, spare_threads_{static_cast<std::ptrdiff_t>(max_threads) - 1},
+          text_measurements_{text_measurements} {}
+
+    // The number of styled nodes in the box, as its children may not have been built yet.
+    // NOLINTNEXTLINE(misc-no-recursion)
+    std::size_t subtree_size(LayoutBox const &box) const {
+        if (!box.is_anonymous_block()) {
+            return subtree_sizes_.at(box.node);
+        }
+
+        std::size_t size = 1;
+        for (auto const &child : box.children) {
+            size += subtree_size(child);
+        }
+
+        return size;
+    }
+
+    // Returns how many of the wanted threads could be had.
+    std::size_t try_acquire_threads(std::size_t wanted) {
+        auto spare = spare_threads_.load(std::memory_order_relaxed);
+        while (spare > 0) {
+            auto const acquired = std::min(spare, static_cast<std::ptrdiff_t>(wanted));
+            if (spare_threads_.compare_exchange_weak(spare, spare - acquired, std::memory_order_relaxed)) {
+                return static_cast<std::size_t>(acquired);
+            }
+        }
+
+        return 0;
+    }
+
+    void release_threads(std::size_t count) {
+        spare_threads_.fetch_add(static_cast<std::ptrdiff_t>(count), std::memory_order_relaxed);
+    }
+
+    // Read by every thread, so nothing is added to it until the layout is done.
+    TextMeasurementCache const &text_measurements() const { return text_measurements_; }
+
+private:
+    std::unordered_map<style::StyledNode const *, std::size_t> subtree_sizes_;
+    std::atomic<std::ptrdiff_t> spare_threads_;
+    TextMeasurementCache const &text_measurements_;
+};
+
 class Layouter {
 public:
     Layouter(style::ResolutionInfo context,
             type::IType const &type,
-            std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url)
-        : resolution_context_{context}, type_{type},
-          get_intrensic_size_for_resource_at_url_{get_intrensic_size_for_resource_at_url} {}
-
-    void layout(LayoutBox &, geom::Rect const &bounds, int last_block_width) const;
+            TextMeasurementCache &text_measurements,
+            std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url,
+            ParallelLayout *parallel = nullptr)
+        : resolution_context_{context}, type_{type}, text_measurements_{text_measurements},
+          get_intrensic_size_for_resource_at_url_{get_intrensic_size_for_resource_at_url}, parallel_{parallel} {}
+
+    void layout(LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const;
+    void relayout(
+            LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width, DirtyNodes const &) const;
+    void layout_lazily(
+            LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width, LazyStop &) const;
+    // `path` is where the last lazy layout stopped, from the outermost box in.
+    void resume_block(LayoutBox &, std::span<std::size_t const> path, LazyStop &) const;
+    // Blocks are built as they're laid out, so the tree is expected to come
+    // from TreeBuilder::build_shallow.
+    void layout_in_parallel(LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const;
 
 private:
     style::ResolutionInfo resolution_context_;
     type::IType const &type_;
+    TextMeasurementCache &text_measurements_;
     std::function<std::optional<Size>(std::string_view)> get_intrensic_size_for_resource_at_url_;
+    ParallelLayout *parallel_{};
 
-    void layout_inline(LayoutBox &, geom::Rect const &bounds, int last_block_width) const;
-    void layout_block(LayoutBox &, geom::Rect const &bounds, int last_block_width) const;
-    void layout_anonymous_block(LayoutBox &, geom::Rect const &bounds, int last_block_width) const;
+    void layout_inline(LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const;
+    void layout_block(
+            LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width, LazyStop * = nullptr) const;
+    void layout_block_children(LayoutBox &, std::size_t first, LazyStop *) const;
+    void layout_block_children_in_parallel(LayoutBox &) const;
+    void layout_anonymous_block(LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const;
 
     void calculate_left_and_right_margin(LayoutBox &,
-            int parent_width,
+            geom::LayoutUnit parent_width,
             style::UnresolvedValue margin_left,
             style::UnresolvedValue margin_right,
             int font_size) const;
-    void calculate_width_and_margin(LayoutBox &, geom::Rect const &parent, int font_size, int last_block_width) const;
+    void calculate_width_and_margin(
+            LayoutBox &, geom::LayoutRect const &parent, int font_size, geom::LayoutUnit last_block_width) const;
     void calculate_inline_height(LayoutBox &, int font_size) const;
     void calculate_non_inline_height(LayoutBox &, int font_size) const;
     void calculate_padding(LayoutBox &, int font_size) const;
     void calculate_border(LayoutBox &, int font_size) const;
     std::optional<std::shared_ptr<type::IFont const>> find_font(std::span<std::string_view const> font_families) const;
+    std::shared_ptr<type::IFont const> find_font_or_fallback(std::span<std::string_view const> font_families) const;
+    bool can_keep_children(LayoutBox const &, DirtyNodes const &) const;
+    void rebuild(LayoutBox &, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const;
+    void build_unbuilt_children(LayoutBox &, bool shallow = true) const;
 };
 
 bool last_node_was_anonymous(LayoutBox const &box) {
     return !box.children.empty() && box.children.back().is_anonymous_block();
 }
 
-// https://www.w3.org/TR/CSS2/visuren.html#box-gen
-// NOLINTNEXTLINE(misc-no-recursion)
-std::optional<LayoutBox> create_tree(
-        style::StyledNode const &node, std::function<bool(std::string_view)> const &resource_exists) {
-    if (auto const *text = std::get_if<dom::Text>(&node.node)) {
-        return LayoutBox{.node = &node, .layout_text = std::string_view{text->text}};
-    }
-
-    assert(std::holds_alternative<dom::Element>(node.node));
-    auto display = node.get_property<css::PropertyId::Display>();
-    if (!display.has_value()) {
-        return std::nullopt;
-    }
-
-    if (auto const &element = std::get<dom::Element>(node.node); element.name == "img"sv) {
-        auto src = element.attributes.find("src"sv);
-        if (src == element.attributes.end() || !resource_exists(src->second)) {
-            if (auto alt = element.attributes.find("alt"sv); alt != element.attributes.end()) {
-                return LayoutBox{.node = &node, .layout_text = std::string_view{alt->second}};
-            }
-        }
-    }
-
-    LayoutBox box{&node};
-
-    for (auto const &child : node.children) {
-        auto child_box = create_tree(child, resource_exists);
-        if (!child_box) {
-            continue;
-        }
-
-        auto child_display = child.get_property<css::PropertyId::Display>();
-        assert(child_display.has_value());
-        if (child_display == style::Display::inline_flow() && display != style::Display::inline_flow()) {
-            if (!last_node_was_anonymous(box)) {
-                box.children.push_back(LayoutBox{nullptr});
-            }
-
-            box.children.back().children.push_back(std::move(*child_box));
-        } else {
-            box.children.push_back(std::move(*child_box));
-        }
-    }
-
-    return box;
-}
-
 constexpr bool is_non_space_whitespace(char c) {
     return c != ' ' && util::is_whitespace(c);
 }
@@ -145,141 +210,301 @@ void remove_empty_text_boxes(LayoutBox &box) {
     }
 }
 
-void collapse_whitespace(LayoutBox &box) {
-    LayoutBox *last_text_box = nullptr;
-    std::list<LayoutBox *> to_collapse{&box};
+void apply_text_transform(LayoutBox &box, std::optional<style::TextTransform> transform) {
+    if (!transform || *transform == style::TextTransform::None) {
+        return;
+    }
 
-    // TODO(robinlinden): More accurate handling of the white-space property.
-    auto starts_text_run = [](LayoutBox const &l) {
-        return !std::holds_alternative<std::monostate>(l.layout_text)
-                && l.get_property<css::PropertyId::WhiteSpace>() == style::WhiteSpace::Normal;
-    };
-    auto ends_text_run = [](LayoutBox const &l) {
-        return l.is_anonymous_block() || l.get_property<css::PropertyId::Display>() != style::Display::inline_flow()
-                || l.get_property<css::PropertyId::WhiteSpace>() != style::WhiteSpace::Normal;
-    };
-    auto needs_allocating_whitespace_collapsing = [](std::string_view text) {
-        return (std::ranges::adjacent_find(
-                        text, [](char a, char b) { return util::is_whitespace(a) && util::is_whitespace(b); })
-                       != std::ranges::end(text))
-                || (std::ranges::find_if(text, is_non_space_whitespace) != std::ranges::end(text));
-    };
-    auto perform_allocating_collapsing = [](LayoutBox &l) {
-        // Copy the string, removing consecutive whitespace, and transforming all whitespace to spaces.
-        auto text = std::get<std::string_view>(l.layout_text);
-        std::string collapsed;
-        std::ranges::unique_copy(text, std::back_inserter(collapsed), [](char a, char b) {
-            return util::is_whitespace(a) && util::is_whitespace(b);
-        });
-        std::ranges::for_each(collapsed, [](char &c) { c = util::is_whitespace(c) ? ' ' : c; });
-        l.layout_text = std::move(collapsed);
-    };
+    if (std::holds_alternative<std::string_view>(box.layout_text)) {
+        box.layout_text = std::string{std::get<std::string_view>(box.layout_text)};
+    }
 
-    for (auto it = to_collapse.begin(); it != to_collapse.end(); ++it) {
-        auto &current = **it;
-        if (last_text_box == nullptr && starts_text_run(current)) {
-            last_text_box = &current;
-            auto &text = std::get<std::string_view>(last_text_box->layout_text);
-            text = util::trim_start(text);
+    auto &text = std::get<std::string>(box.layout_text);
+
+    // TODO(robinlinden): FullWidth, FullSizeKana.
+    // TODO(robinlinden): Handle language-specific cases.
+    switch (*transform) {
+        case style::TextTransform::FullWidth:
+        case style::TextTransform::FullSizeKana:
+        case style::TextTransform::None:
+            break;
+        case style::TextTransform::Uppercase:
+            std::ranges::for_each(text, [](char &c) { c = util::uppercased(c); });
+            break;
+        case style::TextTransform::Lowercase:
+            std::ranges::for_each(text, [](char &c) { c = util::lowercased(c); });
+            break;
+        case style::TextTransform::Capitalize:
+            std::ranges::for_each(text, [first = true](char &c) mutable {
+                if (first && util::is_alpha(c)) {
+                    first = false;
+                    c = util::uppercased(c);
+                } else if (!first && !util::is_alpha(c)) {
+                    first = true;
+                } else {
+                    c = util::lowercased(c);
+                }
+            });
+            break;
+    }
+}
 
-            // A completely empty text box can't start a text run.
-            if (text.empty()) {
-                last_text_box = nullptr;
-            }
-        } else if (last_text_box != nullptr
-                && (!std::holds_alternative<std::monostate>(current.layout_text)
-                        && current.get_property<css::PropertyId::WhiteSpace>() == style::WhiteSpace::Normal)) {
-            // Remove all but 1 trailing space.
-            auto &last_text = std::get<std::string_view>(last_text_box->layout_text);
-            auto last_non_whitespace_idx = last_text.find_last_not_of(" \n\r\f\v\t");
-            if (last_non_whitespace_idx != std::string_view::npos) {
-                auto trailing_whitespace_count = last_text.size() - last_non_whitespace_idx - 1;
-                if (trailing_whitespace_count > 1) {
-                    last_text.remove_suffix(trailing_whitespace_count - 1);
+// The properties the text in a box depends on. Text nodes don't have any
+// properties of their own, so they use their parent's.
+struct TextStyle {
+    std::optional<style::WhiteSpace> white_space;
+    std::optional<style::TextTransform> text_transform;
+
+    static TextStyle of(style::StyledNode const &node) {
+        return {
+                .white_space = node.get_property<css::PropertyId::WhiteSpace>(),
+                .text_transform = node.get_property<css::PropertyId::TextTransform>(),
+        };
+    }
+};
+
+// https://www.w3.org/TR/CSS2/visuren.html#box-gen
+// Creates the layout tree in a single pre-order walk over the styled tree,
+// collapsing whitespace and applying text transforms as the text boxes are
+// created.
+//
+// A text box may need trailing whitespace trimmed depending on what comes
+// after it, so the last text box of the current run of text is kept around.
+// To keep that pointer valid, every box reserves room for all of its children
+// before any are added.
+// TODO(robinlinden): More accurate handling of the white-space property.
+class TreeBuilder {
+public:
+    explicit TreeBuilder(std::function<bool(std::string_view)> const &resource_exists)
+        : resource_exists_{resource_exists} {}
+
+    std::optional<LayoutBox> build(style::StyledNode const &);
+    // Leaves the children of the node's block-level children out, so that
+    // they can be built once they're needed. Building those children later
+    // gives the same result as building everything at once.
+    std::optional<LayoutBox> build_shallow(style::StyledNode const &);
+
+private:
+    std::function<bool(std::string_view)> const &resource_exists_;
+    bool shallow_{false};
+
+    // Whether we're in a run of text w/ whitespace that collapses across boxes.
+    bool in_text_run_{false};
+    // The last text box of the current run, or null if its text collapsed away.
+    LayoutBox *last_text_box_{};
+    std::optional<style::TextTransform> last_text_transform_;
+    // Whether there are boxes that turned out to be empty once they were already in the tree.
+    bool has_empty_text_boxes_{false};
+
+    void build_children(LayoutBox &, style::StyledNode const &, style::Display, TextStyle const &);
+    std::optional<std::string_view> collapse_text(std::string_view, TextStyle const &);
+    void add_text_box(LayoutBox &, TextStyle const &);
+    void end_text_run();
+    static void finish_text_box(LayoutBox &, std::optional<style::TextTransform>);
+};
+
+std::optional<LayoutBox> TreeBuilder::build_shallow(style::StyledNode const &node) {
+    shallow_ = true;
+    return build(node);
+}
+
+std::optional<LayoutBox> TreeBuilder::build(style::StyledNode const &node) {
+    std::optional<LayoutBox> root;
+    if (auto const *text = std::get_if<dom::Text>(&node.node)) {
+        auto style = TextStyle::of(node);
+        auto collapsed = collapse_text(text->text, style);
+        root = LayoutBox{.node = &node, .layout_text = collapsed.value_or(""sv)};
+        if (collapsed.has_value()) {
+            add_text_box(*root, style);
+        }
+    } else if (auto display = node.get_property<css::PropertyId::Display>()) {
+        root = LayoutBox{&node};
+        end_text_run();
+        build_children(*root, node, *display, TextStyle::of(node));
+    }
+
+    end_text_run();
+    if (root && has_empty_text_boxes_) {
+        remove_empty_text_boxes(*root);
+    }
+
+    return root;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void TreeBuilder::build_children(
+        LayoutBox &box, style::StyledNode const &node, style::Display display, TextStyle const &style) {
+    box.children.reserve(node.children.size());
+    for (std::size_t i = 0; i < node.children.size(); ++i) {
+        auto const &child = node.children[i];
+        auto const *element = std::get_if<dom::Element>(&child.node);
+        auto child_display = element != nullptr ? child.get_property<css::PropertyId::Display>()
+                                                : std::optional{style::Display::inline_flow()};
+        if (!child_display.has_value()) {
+            continue;
+        }
+
+        auto child_style = element != nullptr ? TextStyle::of(child) : style;
+        std::optional<std::string_view> text;
+        if (element == nullptr) {
+            text = std::get<dom::Text>(child.node).text;
+        } else if (element->name == "img"sv) {
+            auto src = element->attributes.find("src"sv);
+            if (src == element->attributes.end() || !resource_exists_(src->second)) {
+                if (auto alt = element->attributes.find("alt"sv); alt != element->attributes.end()) {
+                    text = alt->second;
                 }
             }
+        }
 
-            if (last_text.empty() || util::is_whitespace(last_text.back())) {
-                current.layout_text = util::trim_start(std::get<std::string_view>(current.layout_text));
+        auto wrap_in_anonymous_block = child_display == style::Display::inline_flow()
+                && display != style::Display::inline_flow() && !last_node_was_anonymous(box);
+        if (wrap_in_anonymous_block) {
+            end_text_run();
+        }
+
+        // Blocks start new lines, so text never collapses across their edges.
+        auto const is_block = *child_display != style::Display::inline_flow();
+        if (is_block) {
+            end_text_run();
+        }
+
+        bool collapsed_away = false;
+        if (text.has_value()) {
+            text = collapse_text(*text, child_style);
+            if (!text.has_value() && *child_display == style::Display::inline_flow()) {
+                continue;
             }
 
-            if (needs_allocating_whitespace_collapsing(last_text)) {
-                perform_allocating_collapsing(*last_text_box);
+            // A block still splits the inline content around it into separate
+            // anonymous blocks, so it's only removed once everything's built.
+            if (!text.has_value()) {
+                collapsed_away = true;
+                has_empty_text_boxes_ = true;
             }
+        } else if (child_style.white_space != style::WhiteSpace::Normal) {
+            end_text_run();
+        }
 
-            last_text_box = &current;
-        } else if (last_text_box != nullptr && ends_text_run(current)) {
-            last_text_box->layout_text = util::trim_end(std::get<std::string_view>(last_text_box->layout_text));
-            if (needs_allocating_whitespace_collapsing(std::get<std::string_view>(last_text_box->layout_text))) {
-                perform_allocating_collapsing(*last_text_box);
+        auto *parent = &box;
+        if (child_display == style::Display::inline_flow() && display != style::Display::inline_flow()) {
+            if (wrap_in_anonymous_block) {
+                box.children.push_back(LayoutBox{nullptr});
+                box.children.back().children.reserve(node.children.size() - i);
             }
-            last_text_box = nullptr;
+
+            parent = &box.children.back();
         }
 
-        for (std::size_t child_idx = 0; child_idx < current.children.size(); ++child_idx) {
-            auto insertion_point = it;
-            std::advance(insertion_point, 1 + child_idx);
-            to_collapse.insert(insertion_point, &current.children[child_idx]);
+        assert(parent->children.size() < parent->children.capacity());
+        auto &child_box = parent->children.emplace_back(LayoutBox{&child});
+        if (collapsed_away) {
+            child_box.layout_text = ""sv;
+        } else if (text.has_value()) {
+            child_box.layout_text = *text;
+            add_text_box(child_box, child_style);
+        } else if (!shallow_ || display == style::Display::inline_flow()
+                || child_display == style::Display::inline_flow()) {
+            // Only blocks in blocks are laid out lazily, so everything inside
+            // an inline, including blocks in it, is built right away.
+            auto const shallow = std::exchange(shallow_, false);
+            build_children(child_box, child, *child_display, child_style);
+            shallow_ = shallow;
         }
-    }
 
-    if (last_text_box != nullptr) {
-        last_text_box->layout_text = util::trim_end(std::get<std::string_view>(last_text_box->layout_text));
-        if (needs_allocating_whitespace_collapsing(std::get<std::string_view>(last_text_box->layout_text))) {
-            perform_allocating_collapsing(*last_text_box);
+        if (is_block) {
+            end_text_run();
         }
     }
-
-    remove_empty_text_boxes(box);
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-void apply_text_transforms(LayoutBox &box) {
-    if (std::holds_alternative<std::string>(box.layout_text)
-            || std::holds_alternative<std::string_view>(box.layout_text)) {
-        if (auto transform = box.get_property<css::PropertyId::TextTransform>();
-                transform && *transform != style::TextTransform::None) {
-            if (std::holds_alternative<std::string_view>(box.layout_text)) {
-                box.layout_text = std::string{std::get<std::string_view>(box.layout_text)};
-            }
+// Returns the text w/ any leading whitespace that collapses w/ the text before
+// it removed, or nullopt if nothing's left of it.
+std::optional<std::string_view> TreeBuilder::collapse_text(std::string_view text, TextStyle const &style) {
+    if (style.white_space != style::WhiteSpace::Normal) {
+        end_text_run();
+        if (text.empty()) {
+            return std::nullopt;
+        }
 
-            auto &text = std::get<std::string>(box.layout_text);
-
-            // TODO(robinlinden): FullWidth, FullSizeKana.
-            // TODO(robinlinden): Handle language-specific cases.
-            switch (*transform) {
-                case style::TextTransform::FullWidth:
-                case style::TextTransform::FullSizeKana:
-                case style::TextTransform::None:
-                    break;
-                case style::TextTransform::Uppercase:
-                    std::ranges::for_each(text, [](char &c) { c = util::uppercased(c); });
-                    break;
-                case style::TextTransform::Lowercase:
-                    std::ranges::for_each(text, [](char &c) { c = util::lowercased(c); });
-                    break;
-                case style::TextTransform::Capitalize:
-                    std::ranges::for_each(text, [first = true](char &c) mutable {
-                        if (first && util::is_alpha(c)) {
-                            first = false;
-                            c = util::uppercased(c);
-                        } else if (!first && !util::is_alpha(c)) {
-                            first = true;
-                        } else {
-                            c = util::lowercased(c);
-                        }
-                    });
-                    break;
+        return text;
+    }
+
+    if (!in_text_run_) {
+        text = util::trim_start(text);
+        in_text_run_ = !text.empty();
+    } else if (last_text_box_ == nullptr) {
+        text = util::trim_start(text);
+    } else {
+        // Remove all but 1 trailing space.
+        auto &last_text = std::get<std::string_view>(last_text_box_->layout_text);
+        auto last_non_whitespace_idx = last_text.find_last_not_of(" \n\r\f\v\t");
+        if (last_non_whitespace_idx != std::string_view::npos) {
+            auto trailing_whitespace_count = last_text.size() - last_non_whitespace_idx - 1;
+            if (trailing_whitespace_count > 1) {
+                last_text.remove_suffix(trailing_whitespace_count - 1);
             }
         }
+
+        if (last_text.empty() || util::is_whitespace(last_text.back())) {
+            text = util::trim_start(text);
+        }
+
+        finish_text_box(*last_text_box_, last_text_transform_);
     }
 
-    for (auto &child : box.children) {
-        apply_text_transforms(child);
+    last_text_box_ = nullptr;
+    if (text.empty()) {
+        return std::nullopt;
     }
+
+    return text;
 }
 
-void calculate_position(LayoutBox &box, geom::Rect const &parent) {
+void TreeBuilder::add_text_box(LayoutBox &box, TextStyle const &style) {
+    if (style.white_space != style::WhiteSpace::Normal) {
+        apply_text_transform(box, style.text_transform);
+        return;
+    }
+
+    last_text_box_ = &box;
+    last_text_transform_ = style.text_transform;
+}
+
+void TreeBuilder::end_text_run() {
+    if (last_text_box_ != nullptr) {
+        auto &text = std::get<std::string_view>(last_text_box_->layout_text);
+        text = util::trim_end(text);
+        has_empty_text_boxes_ = has_empty_text_boxes_ || text.empty();
+        finish_text_box(*last_text_box_, last_text_transform_);
+    }
+
+    in_text_run_ = false;
+    last_text_box_ = nullptr;
+}
+
+// Nothing after the box can affect its text anymore.
+void TreeBuilder::finish_text_box(LayoutBox &box, std::optional<style::TextTransform> transform) {
+    auto text = std::get<std::string_view>(box.layout_text);
+    auto needs_allocating_collapsing =
+            (std::ranges::adjacent_find(
+                     text, [](char a, char b) { return util::is_whitespace(a) && util::is_whitespace(b); })
+                    != std::ranges::end(text))
+            || (std::ranges::find_if(text, is_non_space_whitespace) != std::ranges::end(text));
+    if (needs_allocating_collapsing) {
+        // Copy the string, removing consecutive whitespace, and transforming all whitespace to spaces.
+        std::string collapsed;
+        std::ranges::unique_copy(text, std::back_inserter(collapsed), [](char a, char b) {
+            return util::is_whitespace(a) && util::is_whitespace(b);
+        });
+        std::ranges::for_each(collapsed, [](char &c) { c = util::is_whitespace(c) ? ' ' : c; });
+        box.layout_text = std::move(collapsed);
+    }
+
+    apply_text_transform(box, transform);
+}
+
+void calculate_position(LayoutBox &box, geom::LayoutRect const &parent) {
     auto const &d = box.dimensions;
     box.dimensions.content.x = parent.x + d.padding.left + d.border.left + d.margin.left;
     // Position below previous content in parent.
@@ -287,7 +512,16 @@ void calculate_position(LayoutBox &box, geom::Rect const &parent) {
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
-void Layouter::layout(LayoutBox &box, geom::Rect const &bounds, int last_block_width) const {
+void translate(LayoutBox &box, geom::LayoutUnit dx, geom::LayoutUnit dy) {
+    box.dimensions.content.x += dx;
+    box.dimensions.content.y += dy;
+    for (auto &child : box.children) {
+        translate(child, dx, dy);
+    }
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void Layouter::layout(LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const {
     if (box.is_anonymous_block()) {
         layout_anonymous_block(box, bounds, last_block_width);
         return;
@@ -328,7 +562,7 @@ std::string_view try_get_src(LayoutBox const &box) {
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
-void Layouter::layout_inline(LayoutBox &box, geom::Rect const &bounds, int last_block_width) const {
+void Layouter::layout_inline(LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const {
     assert(box.node);
     auto font_size = box.get_property<css::PropertyId::FontSize>();
     calculate_padding(box, font_size);
@@ -338,13 +572,8 @@ void Layouter::layout_inline(LayoutBox &box, geom::Rect const &bounds, int last_
         assert(box.children.empty());
         auto font_families = box.get_property<css::PropertyId::FontFamily>();
         auto weight = to_type(box.get_property<css::PropertyId::FontWeight>());
-        auto font = find_font(font_families);
-        if (font) {
-            box.dimensions.content.width = (*font)->measure(*text, type::Px{font_size}, weight).width;
-        } else {
-            spdlog::warn("No font found for font-families: {}", util::join(font_families, ", "));
-            box.dimensions.content.width = type::NaiveFont{}.measure(*text, type::Px{font_size}, weight).width;
-        }
+        auto font = find_font_or_fallback(font_families);
+        box.dimensions.content.width = text_measurements_.measure(font, *text, type::Px{font_size}, weight).width;
     } else if (auto src = try_get_src(box); !src.empty()) {
         // https://www.w3.org/TR/CSS22/visudet.html#inline-replaced-width
         // TODO(robinlinden): Apply things like max-{width,height}.
@@ -365,7 +594,7 @@ void Layouter::layout_inline(LayoutBox &box, geom::Rect const &bounds, int last_
         box.dimensions.content.y = bounds.y + d.border.top + d.padding.top + d.margin.top;
     }
 
-    int last_child_end{};
+    geom::LayoutUnit last_child_end{};
     for (auto &child : box.children) {
         layout(child, box.dimensions.content.translated(last_child_end, 0), last_block_width);
         last_child_end += child.dimensions.margin_box().width;
@@ -376,7 +605,8 @@ void Layouter::layout_inline(LayoutBox &box, geom::Rect const &bounds, int last_
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
-void Layouter::layout_block(LayoutBox &box, geom::Rect const &bounds, int last_block_width) const {
+void Layouter::layout_block(
+        LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width, LazyStop *stop) const {
     // TODO(robinlinden): Support <img> sizing. Enable block <img> in //render once done.
     assert(box.node);
     auto font_size = box.get_property<css::PropertyId::FontSize>();
@@ -384,35 +614,232 @@ void Layouter::layout_block(LayoutBox &box, geom::Rect const &bounds, int last_b
     calculate_border(box, font_size);
     calculate_width_and_margin(box, bounds, font_size, last_block_width);
     calculate_position(box, bounds);
-    for (auto &child : box.children) {
-        layout(child, box.dimensions.content, box.dimensions.content.width);
+    layout_block_children(box, 0, stop);
+    calculate_non_inline_height(box, font_size);
+}
+
+// Only blocks nested directly in blocks are laid out lazily, so that
+// resuming never has to continue in the middle of a line.
+// NOLINTNEXTLINE(misc-no-recursion)
+void Layouter::layout_block_children(LayoutBox &box, std::size_t first, LazyStop *stop) const {
+    for (auto i = first; i < box.children.size(); ++i) {
+        auto &child = box.children[i];
+        if (stop == nullptr) {
+            layout(child, box.dimensions.content, box.dimensions.content.width);
+        } else if (box.dimensions.content.bottom().ceil() > stop->below) {
+            stop->path.push_back(i);
+            return;
+        } else if (!child.is_anonymous_block()
+                && child.get_property<css::PropertyId::Display>() != style::Display::inline_flow()) {
+            build_unbuilt_children(child);
+            layout_block(child, box.dimensions.content, box.dimensions.content.width, stop);
+        } else {
+            layout(child, box.dimensions.content, box.dimensions.content.width);
+        }
+
+        box.dimensions.content.height += child.dimensions.margin_box().height;
+        if (stop != nullptr && !stop->path.empty()) {
+            stop->path.push_back(i);
+            return;
+        }
+    }
+}
+
+void Layouter::layout_lazily(
+        LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width, LazyStop &stop) const {
+    if (box.is_anonymous_block() || box.get_property<css::PropertyId::Display>() == style::Display::inline_flow()) {
+        layout(box, bounds, last_block_width);
+        return;
+    }
+
+    layout_block(box, bounds, last_block_width, &stop);
+}
+
+// The boxes before the one to continue w/ are done, and neither they nor the
+// box's position or width change.
+// NOLINTNEXTLINE(misc-no-recursion)
+void Layouter::resume_block(LayoutBox &box, std::span<std::size_t const> path, LazyStop &stop) const {
+    assert(!path.empty());
+    auto next = path.front();
+    box.dimensions.content.height = 0;
+    for (auto const &child : std::span{box.children}.first(next)) {
         box.dimensions.content.height += child.dimensions.margin_box().height;
     }
+
+    if (path.size() > 1) {
+        auto &child = box.children[next];
+        resume_block(child, path.subspan(1), stop);
+        box.dimensions.content.height += child.dimensions.margin_box().height;
+        next += 1;
+    }
+
+    if (stop.path.empty()) {
+        layout_block_children(box, next, &stop);
+    } else {
+        stop.path.push_back(next - 1);
+    }
+
+    calculate_non_inline_height(box, box.get_property<css::PropertyId::FontSize>());
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void Layouter::layout_in_parallel(
+        LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const {
+    assert(parallel_ != nullptr);
+    // Everything in inlines and anonymous blocks is built right away.
+    if (box.is_anonymous_block() || box.get_property<css::PropertyId::Display>() == style::Display::inline_flow()) {
+        layout(box, bounds, last_block_width);
+        return;
+    }
+
+    // Too small to split up between threads, so it's all done here.
+    if (parallel_->subtree_size(box) < 2 * kMinParallelSubtreeSize) {
+        build_unbuilt_children(box, false);
+        layout(box, bounds, last_block_width);
+        return;
+    }
+
+    build_unbuilt_children(box);
+    auto font_size = box.get_property<css::PropertyId::FontSize>();
+    calculate_padding(box, font_size);
+    calculate_border(box, font_size);
+    calculate_width_and_margin(box, bounds, font_size, last_block_width);
+    calculate_position(box, bounds);
+    layout_block_children_in_parallel(box);
     calculate_non_inline_height(box, font_size);
 }
 
+// A block's children only depend on the blocks before them for where they
+// start vertically, so runs of them are laid out as if they were first in the
+// block, each on its own thread, and then moved down below the runs before
+// them. Moving a box moves everything in it by exactly as much, so this ends
+// up the same as laying them out one after the other.
 // NOLINTNEXTLINE(misc-no-recursion)
-void Layouter::layout_anonymous_block(LayoutBox &box, geom::Rect const &bounds, int last_block_width) const {
+void Layouter::layout_block_children_in_parallel(LayoutBox &box) const {
+    // Split the children into runs of about the same size, one for each thread
+    // there is. The first run is kept on this thread, as are runs too small to
+    // be worth a thread of their own. Those are laid out while waiting for the
+    // others.
+    struct Run {
+        std::size_t begin{};
+        std::size_t end{};
+        std::size_t size{};
+        geom::LayoutUnit height{};
+    };
+
+    std::vector<std::size_t> sizes;
+    sizes.reserve(box.children.size());
+    std::size_t total = 0;
+    for (auto const &child : box.children) {
+        total += sizes.emplace_back(parallel_->subtree_size(child));
+    }
+
+    auto const max_runs = std::min(total / kMinParallelSubtreeSize, box.children.size());
+    auto threads = parallel_->try_acquire_threads(max_runs > 0 ? max_runs - 1 : 0);
+    auto const run_count = threads + 1;
+
+    std::vector<Run> runs;
+    runs.reserve(run_count);
+    std::size_t done = 0;
+    for (std::size_t i = 0; i < box.children.size(); ++i) {
+        if (runs.empty() || (done >= runs.size() * total / run_count && runs.size() < run_count)) {
+            runs.push_back({i, i});
+        }
+
+        done += sizes[i];
+        runs.back().end = i + 1;
+        runs.back().size += sizes[i];
+    }
+
+    // Nothing may change the block's dimensions until all runs are done.
+    auto const &content = box.dimensions.content;
+    // NOLINTNEXTLINE(misc-no-recursion)
+    auto layout_run = [&box, &content](Layouter const &layouter, Run &run) {
+        auto bounds = content;
+        for (std::size_t i = run.begin; i < run.end; ++i) {
+            auto &child = box.children[i];
+            layouter.layout_in_parallel(child, bounds, content.width);
+            bounds.height += child.dimensions.margin_box().height;
+        }
+
+        run.height = bounds.height - content.height;
+    };
+
+    std::vector<std::future<TextMeasurementCache>> spawned;
+    std::vector<Run *> kept;
+    for (auto &run : runs) {
+        if (&run == &runs.front() || threads == 0 || run.size < kMinParallelSubtreeSize) {
+            kept.push_back(&run);
+            continue;
+        }
+
+        // The measurements made on other threads are kept apart until they're
+        // done, as this thread's cache may be changed at any time.
+        threads -= 1;
+        // NOLINTNEXTLINE(misc-no-recursion)
+        spawned.push_back(std::async(std::launch::async, [&, this] {
+            TextMeasurementCache text_measurements{&parallel_->text_measurements()};
+            Layouter const layouter{
+                    resolution_context_, type_, text_measurements, get_intrensic_size_for_resource_at_url_, parallel_};
+            layout_run(layouter, run);
+            parallel_->release_threads(1);
+            return text_measurements;
+        }));
+    }
+
+    // Threads the runs turned out to be too uneven to use.
+    parallel_->release_threads(threads);
+    for (auto *run : kept) {
+        layout_run(*this, *run);
+    }
+
+    for (auto &future : spawned) {
+        text_measurements_.merge(future.get());
+    }
+
+    geom::LayoutUnit height{};
+    for (auto const &run : runs) {
+        if (height != 0) {
+            for (auto &child : std::span{box.children}.subspan(run.begin, run.end - run.begin)) {
+                translate(child, 0, height);
+            }
+        }
+
+        height += run.height;
+    }
+
+    box.dimensions.content.height += height;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void Layouter::layout_anonymous_block(
+        LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const {
     calculate_position(box, bounds);
     box.dimensions.content.width = last_block_width;
-    int last_child_end{};
+    geom::LayoutUnit last_child_end{};
     int current_line{};
     auto font_size = type::Px{box.get_property<css::PropertyId::FontSize>()};
     auto font_families = box.get_property<css::PropertyId::FontFamily>();
 
-    auto maybe_font = find_font(font_families);
-    if (!maybe_font) {
-        spdlog::warn("No font found for font-families: {}", util::join(font_families, ", "));
-        maybe_font = std::make_shared<type::NaiveFont>();
-    }
-    auto font = *maybe_font;
+    auto font = find_font_or_fallback(font_families);
 
     auto weight = to_type(box.get_property<css::PropertyId::FontWeight>());
 
     // TODO(robinlinden): This function should probably be looking at the child-items' height.
     auto line_height = box.get_property<css::PropertyId::LineHeight>().resolve(font_size.v, resolution_context_);
 
-    for (std::size_t i = 0; i < box.children.size(); ++i) {
+    // Text split over several lines gets a box per line, added right after the
+    // box being split. To not have to shift all boxes after it, the children
+    // are moved back into the box one at a time as they're laid out, so the
+    // box being split is always the last one.
+    auto children = std::move(box.children);
+    box.children.clear();
+    box.children.reserve(children.size());
+    for (std::size_t i = 0, next = 0; i < box.children.size() || next < children.size(); ++i) {
+        if (i == box.children.size()) {
+            box.children.push_back(std::move(children[next++]));
+        }
+
         auto *child = &box.children[i];
         layout(*child, box.dimensions.content.translated(last_child_end, current_line * line_height), last_block_width);
 
@@ -440,29 +867,97 @@ void Layouter::layout_anonymous_block(LayoutBox &box, geom::Rect const &bounds,
             if (maybe_text.has_value()) {
                 std::string_view text = *maybe_text;
 
-                std::size_t best_split_point = std::string_view::npos;
-                for (auto split_point = text.find(' '); split_point != std::string_view::npos;
-                        split_point = text.find(' ', split_point + 1)) {
-                    if (last_child_end + font->measure(text.substr(0, split_point), font_size, weight).width
-                            > bounds.width) {
+                // Break the text into as many lines as it needs in one go. The
+                // advance at the end of every word is known up front, so a
+                // line's last word is the last one ending within it.
+                auto const &word_ends = text_measurements_.word_ends(font, text, font_size, weight);
+                auto const space_width = text_measurements_.measure(font, " ", font_size, weight).width;
+                std::vector<std::size_t> line_ends; // Index of each line's last word.
+                std::size_t line_start = 0;
+                int line_start_advance = 0;
+                // The advances are in whole pixels, so the fractions of pixels don't matter here.
+                int available_width = (bounds.width - last_child_end).floor();
+                while (true) {
+                    // The last word has no space after it to break at.
+                    auto const candidates = std::span{word_ends}.subspan(line_start, word_ends.size() - 1 - line_start);
+                    auto const fitting = std::ranges::upper_bound(candidates, line_start_advance + available_width);
+                    if (fitting == candidates.begin()) {
                         break;
                     }
 
-                    best_split_point = split_point;
+                    line_start += static_cast<std::size_t>(std::distance(candidates.begin(), fitting));
+                    line_ends.push_back(line_start - 1);
+                    line_start_advance = word_ends[line_start - 1] + space_width;
+                    available_width = bounds.width.floor();
+                    if (word_ends.back() - line_start_advance <= available_width) {
+                        break;
+                    }
                 }
 
-                if (best_split_point != std::string_view::npos) {
+                if (!line_ends.empty()) {
+                    // Map the word indices back to the spaces they end at.
+                    std::vector<std::size_t> split_points;
+                    split_points.reserve(line_ends.size());
+                    std::size_t word = 0;
+                    for (auto split_point = text.find(' '); split_points.size() < line_ends.size();
+                            split_point = text.find(' ', split_point + 1), ++word) {
+                        if (word == line_ends[split_points.size()]) {
+                            split_points.push_back(split_point);
+                        }
+                    }
+
+                    // The lines are views into the text. Text the layout
+                    // had to create is moved into a string shared by all of
+                    // its lines instead of copied into each one of them.
+                    if (auto *owned = std::get_if<std::string>(&child->layout_text)) {
+                        auto shared = std::make_shared<std::string const>(std::move(*owned));
+                        text = *shared;
+                        child->layout_text = TextSlice{std::move(shared), text};
+                    }
+
+                    auto *slice = std::get_if<TextSlice>(&child->layout_text);
+                    std::vector<LayoutBox> bonus_children;
+                    bonus_children.reserve(split_points.size());
+                    for (std::size_t line = 0; line < split_points.size(); ++line) {
+                        auto const start = split_points[line] + 1;
+                        auto const end = line + 1 < split_points.size() ? split_points[line + 1] : text.size();
+                        auto line_text = text.substr(start, end - start);
+                        auto &bonus_child = bonus_children.emplace_back(
+                                LayoutBox{.node = child->node, .dimensions = child->dimensions});
+                        if (slice != nullptr) {
+                            bonus_child.layout_text = TextSlice{slice->owner, line_text};
+                        } else {
+                            bonus_child.layout_text = line_text;
+                        }
+                    }
+
+                    auto const first_line = text.substr(0, split_points[0]);
                     child->dimensions.content.width =
-                            font->measure(text.substr(0, best_split_point), font_size, weight).width;
-                    auto bonus_child = *child;
-                    bonus_child.layout_text = std::string{text.substr(best_split_point + 1)};
-                    box.children.insert(box.children.begin() + i + 1, std::move(bonus_child));
+                            text_measurements_.measure(font, first_line, font_size, weight).width;
+                    if (slice != nullptr) {
+                        slice->text = first_line;
+                    } else {
+                        child->layout_text = first_line;
+                    }
+
+                    assert(i + 1 == box.children.size());
+                    box.children.insert(box.children.end(),
+                            std::make_move_iterator(bonus_children.begin()),
+                            std::make_move_iterator(bonus_children.end()));
                     current_line += 1;
                     last_child_end = 0;
 
-                    // Adding a child may have had to relocate the container content.
-                    child = &box.children[i];
-                    child->layout_text = std::string{text.substr(0, best_split_point)};
+                    // Every line but the last one is full, so those are done
+                    // here. The last one is laid out like any other child as
+                    // there may be room for more things after it.
+                    auto const last_line = i + bonus_children.size();
+                    for (++i; i < last_line; ++i) {
+                        layout(box.children[i],
+                                box.dimensions.content.translated(0, current_line * line_height),
+                                last_block_width);
+                        current_line += 1;
+                    }
+                    --i;
                 } else {
                     last_child_end += child->dimensions.margin_box().width;
                 }
@@ -477,19 +972,117 @@ void Layouter::layout_anonymous_block(LayoutBox &box, geom::Rect const &bounds,
     box.dimensions.content.height = last_size.y - box.dimensions.margin_box().y + last_size.height;
 }
 
+// Only called for block-level boxes containing something dirty. Blocks w/o
+// anything dirty in them keep their size, so they're just moved.
+// NOLINTNEXTLINE(misc-no-recursion)
+void Layouter::relayout(LayoutBox &box,
+        geom::LayoutRect const &bounds,
+        geom::LayoutUnit last_block_width,
+        DirtyNodes const &dirty) const {
+    assert(!box.is_anonymous_block());
+    if (dirty.dirty.contains(box.node) || !can_keep_children(box, dirty)) {
+        rebuild(box, bounds, last_block_width);
+        return;
+    }
+
+    calculate_position(box, bounds);
+    box.dimensions.content.height = 0;
+    for (auto &child : box.children) {
+        if (!child.is_anonymous_block() && dirty.affected.contains(child.node)) {
+            relayout(child, box.dimensions.content, box.dimensions.content.width, dirty);
+        } else {
+            auto const old_position = child.dimensions.content.position();
+            calculate_position(child, box.dimensions.content);
+            auto const dx = child.dimensions.content.x - old_position.x;
+            auto const dy = child.dimensions.content.y - old_position.y;
+            if (dx != 0 || dy != 0) {
+                for (auto &grandchild : child.children) {
+                    translate(grandchild, dx, dy);
+                }
+            }
+        }
+
+        box.dimensions.content.height += child.dimensions.margin_box().height;
+    }
+
+    calculate_non_inline_height(box, box.get_property<css::PropertyId::FontSize>());
+}
+
+// The children can be kept if everything affected is in a block-level child
+// that stays block-level. Anything else may change how the children are
+// grouped into anonymous blocks, or which boxes exist at all. Images are built
+// by their parents, as those decide whether an image's alt text is shown.
+bool Layouter::can_keep_children(LayoutBox const &box, DirtyNodes const &dirty) const {
+    auto child_box = box.children.begin();
+    for (auto const &child : box.node->children) {
+        if (!dirty.affected.contains(&child)) {
+            continue;
+        }
+
+        // The boxes are in the same order as the nodes.
+        child_box = std::ranges::find(child_box, box.children.end(), &child, &LayoutBox::node);
+        if (child_box == box.children.end()) {
+            return false;
+        }
+
+        if (dirty.dirty.contains(&child)) {
+            auto display = child.get_property<css::PropertyId::Display>();
+            if (!display.has_value() || *display == style::Display::inline_flow()) {
+                return false;
+            }
+
+            if (auto const *element = std::get_if<dom::Element>(&child.node);
+                    element != nullptr && element->name == "img"sv) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void Layouter::rebuild(LayoutBox &box, geom::LayoutRect const &bounds, geom::LayoutUnit last_block_width) const {
+    auto resource_exists = [this](std::string_view url) {
+        return get_intrensic_size_for_resource_at_url_(url).has_value();
+    };
+
+    // The parent made sure that the node still is block-level, so it gets a box.
+    auto rebuilt = TreeBuilder{resource_exists}.build(*box.node);
+    assert(rebuilt.has_value());
+    box = *std::move(rebuilt);
+    layout(box, bounds, last_block_width);
+}
+
+// Blocks that really don't have any children are built again, but that's
+// both rare and cheap.
+void Layouter::build_unbuilt_children(LayoutBox &box, bool shallow) const {
+    if (!box.children.empty() || box.node->children.empty()) {
+        return;
+    }
+
+    auto resource_exists = [this](std::string_view url) {
+        return get_intrensic_size_for_resource_at_url_(url).has_value();
+    };
+
+    auto built = shallow ? TreeBuilder{resource_exists}.build_shallow(*box.node)
+                         : TreeBuilder{resource_exists}.build(*box.node);
+    assert(built.has_value());
+    box = *std::move(built);
+}
+
 void Layouter::calculate_left_and_right_margin(LayoutBox &box,
-        int const parent_width,
+        geom::LayoutUnit const parent_width,
         style::UnresolvedValue margin_left,
         style::UnresolvedValue margin_right,
         int const font_size) const {
     if (margin_left.is_auto() && margin_right.is_auto()) {
-        int margin_px = (parent_width - box.dimensions.border_box().width) / 2;
+        auto margin_px = (parent_width - box.dimensions.border_box().width) / 2;
         box.dimensions.margin.left = box.dimensions.margin.right = margin_px;
     } else if (margin_left.is_auto() && !margin_right.is_auto()) {
-        box.dimensions.margin.right = margin_right.resolve(font_size, resolution_context_);
+        box.dimensions.margin.right = margin_right.resolve_subpixel(font_size, resolution_context_);
         box.dimensions.margin.left = parent_width - box.dimensions.margin_box().width;
     } else if (!margin_left.is_auto() && margin_right.is_auto()) {
-        box.dimensions.margin.left = margin_left.resolve(font_size, resolution_context_);
+        box.dimensions.margin.left = margin_left.resolve_subpixel(font_size, resolution_context_);
         box.dimensions.margin.right = parent_width - box.dimensions.margin_box().width;
     } else {
         // TODO(mkiael): Compute margin depending on direction property
@@ -497,19 +1090,21 @@ void Layouter::calculate_left_and_right_margin(LayoutBox &box,
 }
 
 // https://www.w3.org/TR/CSS2/visudet.html#blockwidth
-void Layouter::calculate_width_and_margin(
-        LayoutBox &box, geom::Rect const &parent, int const font_size, int const last_block_width) const {
+void Layouter::calculate_width_and_margin(LayoutBox &box,
+        geom::LayoutRect const &parent,
+        int const font_size,
+        geom::LayoutUnit const last_block_width) const {
     assert(box.node != nullptr);
 
     auto &margins = box.dimensions.margin;
     if (auto margin_top = box.get_property<css::PropertyId::MarginTop>(); !margin_top.is_auto()) {
-        margins.top = margin_top.resolve(font_size, resolution_context_);
+        margins.top = margin_top.resolve_subpixel(font_size, resolution_context_);
     } else {
         margins.top = 0;
     }
 
     if (auto margin_bottom = box.get_property<css::PropertyId::MarginBottom>(); !margin_bottom.is_auto()) {
-        margins.bottom = margin_bottom.resolve(font_size, resolution_context_);
+        margins.bottom = margin_bottom.resolve_subpixel(font_size, resolution_context_);
     } else {
         margins.bottom = 0;
     }
@@ -517,9 +1112,9 @@ void Layouter::calculate_width_and_margin(
     auto margin_left = box.get_property<css::PropertyId::MarginLeft>();
     auto margin_right = box.get_property<css::PropertyId::MarginRight>();
     auto width = box.get_property<css::PropertyId::Width>();
-    std::optional<int> resolved_width;
+    std::optional<geom::LayoutUnit> resolved_width;
     if (!width.is_auto()) {
-        resolved_width = width.try_resolve(font_size, resolution_context_, last_block_width);
+        resolved_width = width.try_resolve_subpixel(font_size, resolution_context_, last_block_width);
     }
 
     if (resolved_width) {
@@ -527,16 +1122,16 @@ void Layouter::calculate_width_and_margin(
         calculate_left_and_right_margin(box, last_block_width, margin_left, margin_right, font_size);
     } else {
         if (!margin_left.is_auto()) {
-            margins.left = margin_left.resolve(font_size, resolution_context_);
+            margins.left = margin_left.resolve_subpixel(font_size, resolution_context_);
         }
         if (!margin_right.is_auto()) {
-            margins.right = margin_right.resolve(font_size, resolution_context_);
+            margins.right = margin_right.resolve_subpixel(font_size, resolution_context_);
         }
         box.dimensions.content.width = last_block_width - box.dimensions.margin_box().width;
     }
 
     if (auto min = box.get_property<css::PropertyId::MinWidth>(); !min.is_auto()) {
-        auto resolved = min.resolve(font_size, resolution_context_, last_block_width);
+        auto resolved = min.resolve_subpixel(font_size, resolution_context_, last_block_width);
         if (box.dimensions.content.width < resolved) {
             box.dimensions.content.width = resolved;
             calculate_left_and_right_margin(box, last_block_width, margin_left, margin_right, font_size);
@@ -544,9 +1139,9 @@ void Layouter::calculate_width_and_margin(
     }
 
     auto max = box.get_property<css::PropertyId::MaxWidth>();
-    std::optional<int> resolved_max;
+    std::optional<geom::LayoutUnit> resolved_max;
     if (!max.is_none()) {
-        resolved_max = max.try_resolve(font_size, resolution_context_, parent.width);
+        resolved_max = max.try_resolve_subpixel(font_size, resolution_context_, parent.width);
     }
 
     if (resolved_max) {
@@ -578,30 +1173,34 @@ void Layouter::calculate_non_inline_height(LayoutBox &box, int const font_size)
 
     if (auto height = box.get_property<css::PropertyId::Height>(); !height.is_auto()) {
         if (box.node->parent == nullptr) {
-            content.height = height.resolve(font_size, resolution_context_, resolution_context_.viewport_height);
-        } else if (auto maybe_height = height.try_resolve(font_size, resolution_context_)) {
+            content.height =
+                    height.resolve_subpixel(font_size, resolution_context_, resolution_context_.viewport_height);
+        } else if (auto maybe_height = height.try_resolve_subpixel(font_size, resolution_context_)) {
             content.height = *maybe_height;
         }
     }
 
     if (auto min = box.get_property<css::PropertyId::MinHeight>(); !min.is_auto()) {
-        content.height = std::max(content.height, min.resolve(font_size, resolution_context_));
+        content.height = std::max(content.height, min.resolve_subpixel(font_size, resolution_context_));
     }
 
     if (auto max = box.get_property<css::PropertyId::MaxHeight>(); !max.is_none()) {
-        content.height = std::min(content.height, max.resolve(font_size, resolution_context_));
+        content.height = std::min(content.height, max.resolve_subpixel(font_size, resolution_context_));
     }
 }
 
 void Layouter::calculate_padding(LayoutBox &box, int const font_size) const {
     auto &padding = box.dimensions.padding;
-    padding.left = box.get_property<css::PropertyId::PaddingLeft>().resolve(font_size, resolution_context_);
-    padding.right = box.get_property<css::PropertyId::PaddingRight>().resolve(font_size, resolution_context_);
-    padding.top = box.get_property<css::PropertyId::PaddingTop>().resolve(font_size, resolution_context_);
-    padding.bottom = box.get_property<css::PropertyId::PaddingBottom>().resolve(font_size, resolution_context_);
+    padding.left = box.get_property<css::PropertyId::PaddingLeft>().resolve_subpixel(font_size, resolution_context_);
+    padding.right = box.get_property<css::PropertyId::PaddingRight>().resolve_subpixel(font_size, resolution_context_);
+    padding.top = box.get_property<css::PropertyId::PaddingTop>().resolve_subpixel(font_size, resolution_context_);
+    padding.bottom =
+            box.get_property<css::PropertyId::PaddingBottom>().resolve_subpixel(font_size, resolution_context_);
 }
 
 void Layouter::calculate_border(LayoutBox &box, int const font_size) const {
+    // Borders are kept to whole pixels, like in other browsers, so that they
+    // don't end up blurry or w/ different widths on different sides.
     if (box.get_property<css::PropertyId::BorderLeftStyle>() != style::BorderStyle::None) {
         auto border_width = box.get_property<css::PropertyId::BorderLeftWidth>();
         box.dimensions.border.left = border_width.resolve(font_size, resolution_context_);
@@ -633,6 +1232,35 @@ std::optional<std::shared_ptr<type::IFont const>> Layouter::find_font(
     return std::nullopt;
 }
 
+std::shared_ptr<type::IFont const> Layouter::find_font_or_fallback(
+        std::span<std::string_view const> font_families) const {
+    if (auto font = find_font(font_families)) {
+        return *std::move(font);
+    }
+
+    spdlog::warn("No font found for font-families: {}", util::join(font_families, ", "));
+    // Shared so that the fallback's measurements are cached like any other font's.
+    static auto const kFallback = std::make_shared<type::NaiveFont const>();
+    return kFallback;
+}
+
+TextMeasurementCache &text_measurements_for(LayoutInfo const &info, TextMeasurementCache &local) {
+    auto &text_measurements = info.text_measurements != nullptr ? *info.text_measurements : local;
+    if (text_measurements.size() > kMaxCachedTextMeasurements) {
+        text_measurements.clear();
+    }
+
+    return text_measurements;
+}
+
+style::ResolutionInfo resolution_context_for(style::StyledNode const &root, LayoutInfo const &info) {
+    return {
+            .root_font_size = root.get_property<css::PropertyId::FontSize>(),
+            .viewport_width = info.viewport_width,
+            .viewport_height = info.viewport_height,
+    };
+}
+
 } // namespace
 
 std::optional<LayoutBox> create_layout(style::StyledNode const &node,
@@ -643,25 +1271,141 @@ std::optional<LayoutBox> create_layout(style::StyledNode const &node,
         return get_intrensic_size_for_resource_at_url(url).has_value();
     };
 
-    auto tree = create_tree(node, resource_exists);
+    auto tree = TreeBuilder{resource_exists}.build(node);
     if (!tree) {
         return {};
     }
 
-    // TODO(robinlinden): Merge the different passes. They're separate because
-    // it was easier, but it's definitely less efficient.
-    collapse_whitespace(*tree);
-    apply_text_transforms(*tree);
+    TextMeasurementCache local_text_measurements;
+    Layouter{resolution_context_for(node, info),
+            type,
+            text_measurements_for(info, local_text_measurements),
+            get_intrensic_size_for_resource_at_url}
+            .layout(*tree, {0, 0, info.viewport_width, 0}, info.viewport_width);
+    return tree;
+}
 
-    style::ResolutionInfo resolution_context{
-            .root_font_size = node.get_property<css::PropertyId::FontSize>(),
-            .viewport_width = info.viewport_width,
-            .viewport_height = info.viewport_height,
+std::optional<LayoutBox> create_layout_parallel(style::StyledNode const &node,
+        LayoutInfo const &info,
+        type::IType const &type,
+        std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url,
+        std::size_t max_threads) {
+    if (max_threads <= 1) {
+        return create_layout(node, info, type, get_intrensic_size_for_resource_at_url);
+    }
+
+    std::unordered_map<style::StyledNode const *, std::size_t> subtree_sizes;
+    if (count_subtree_sizes(node, subtree_sizes) < 2 * kMinParallelSubtreeSize) {
+        return create_layout(node, info, type, get_intrensic_size_for_resource_at_url);
+    }
+
+    auto resource_exists = [&get_intrensic_size_for_resource_at_url](std::string_view url) {
+        return get_intrensic_size_for_resource_at_url(url).has_value();
     };
 
-    Layouter{resolution_context, type, get_intrensic_size_for_resource_at_url}.layout(
-            *tree, {0, 0, info.viewport_width, 0}, info.viewport_width);
+    // The blocks' children are built on the threads laying them out.
+    auto tree = TreeBuilder{resource_exists}.build_shallow(node);
+    if (!tree) {
+        return {};
+    }
+
+    TextMeasurementCache local_text_measurements;
+    auto &shared_text_measurements = text_measurements_for(info, local_text_measurements);
+    ParallelLayout parallel{std::move(subtree_sizes), max_threads, shared_text_measurements};
+    TextMeasurementCache text_measurements{&shared_text_measurements};
+    Layouter{resolution_context_for(node, info),
+            type,
+            text_measurements,
+            get_intrensic_size_for_resource_at_url,
+            &parallel}
+            .layout_in_parallel(*tree, {0, 0, info.viewport_width, 0}, info.viewport_width);
+    shared_text_measurements.merge(std::move(text_measurements));
     return tree;
 }
 
+void relayout(std::optional<LayoutBox> &layout,
+        style::StyledNode const &node,
+        std::span<style::StyledNode const *const> dirty,
+        LayoutInfo const &info,
+        type::IType const &type,
+        std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url) {
+    if (dirty.empty() && layout.has_value()) {
+        return;
+    }
+
+    DirtyNodes dirty_nodes{.dirty{dirty.begin(), dirty.end()}};
+    for (auto const *dirty_node : dirty) {
+        for (auto const *n = dirty_node; n != nullptr && dirty_nodes.affected.insert(n).second; n = n->parent) {}
+    }
+
+    // Everything depends on the root, and a root that isn't a block can't be
+    // moved around like the blocks below it.
+    if (!layout.has_value() || layout->node != &node || dirty_nodes.dirty.contains(&node)
+            || layout->get_property<css::PropertyId::Display>() == style::Display::inline_flow()) {
+        layout = create_layout(node, info, type, get_intrensic_size_for_resource_at_url);
+        return;
+    }
+
+    TextMeasurementCache local_text_measurements;
+    Layouter{resolution_context_for(node, info),
+            type,
+            text_measurements_for(info, local_text_measurements),
+            get_intrensic_size_for_resource_at_url}
+            .relayout(*layout, {0, 0, info.viewport_width, 0}, info.viewport_width, dirty_nodes);
+}
+
+LazyLayout::LazyLayout(style::StyledNode const &node,
+        LayoutInfo const &info,
+        type::IType const &type,
+        std::function<std::optional<Size>(std::string_view)> get_intrensic_size_for_resource_at_url)
+    : root_{&node}, info_{info}, type_{&type},
+      get_intrensic_size_for_resource_at_url_{std::move(get_intrensic_size_for_resource_at_url)},
+      laid_out_until_{2 * info.viewport_height} {
+    auto resource_exists = [this](std::string_view url) {
+        return get_intrensic_size_for_resource_at_url_(url).has_value();
+    };
+
+    layout_ = TreeBuilder{resource_exists}.build_shallow(node);
+    if (!layout_) {
+        return;
+    }
+
+    LazyStop stop{.below = laid_out_until_};
+    Layouter{resolution_context_for(node, info_),
+            *type_,
+            text_measurements_for(info_, local_text_measurements_),
+            get_intrensic_size_for_resource_at_url_}
+            .layout_lazily(*layout_, {0, 0, info_.viewport_width, 0}, info_.viewport_width, stop);
+    stopped_at_.assign(stop.path.rbegin(), stop.path.rend());
+}
+
+void LazyLayout::layout_until(int y) {
+    if (is_complete() || y <= laid_out_until_) {
+        return;
+    }
+
+    laid_out_until_ = y;
+    LazyStop stop{.below = y};
+    Layouter{resolution_context_for(*root_, info_),
+            *type_,
+            text_measurements_for(info_, local_text_measurements_),
+            get_intrensic_size_for_resource_at_url_}
+            .resume_block(*layout_, stopped_at_, stop);
+    stopped_at_.assign(stop.path.rbegin(), stop.path.rend());
+}
+
+std::optional<LayoutBox> const &LazyLayout::layout_all() {
+    layout_until(std::numeric_limits<int>::max());
+    return layout_;
+}
+
+LayoutBox const *LazyLayout::box_at_position(geom::Position p) {
+    if (!layout_) {
+        return nullptr;
+    }
+
+    layout_until(p.y);
+    return layout::box_at_position(*layout_, p);
+}
+
 } // namespace layout
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -6,20 +6,29 @@
 #define LAYOUT_LAYOUT_H_
 
 #include "layout/layout_box.h"
+#include "layout/text_measurement_cache.h"
 
+#include "geom/geom.h"
 #include "style/styled_node.h"
 #include "type/naive.h"
 #include "type/type.h"
 
+#include <cstddef>
 #include <functional>
 #include <optional>
+#include <span>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 namespace layout {
 
 struct LayoutInfo {
     int viewport_width{};
     int viewport_height{};
+    // Kept between layouts so that text that's already been measured doesn't
+    // have to be measured again. A temporary cache is used if this is null.
+    TextMeasurementCache *text_measurements{};
 };
 
 struct Size {
@@ -35,6 +44,69 @@ std::optional<LayoutBox> create_layout(
         std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url =
                 [](std::string_view) { return std::nullopt; });
 
+// Lays out the children of large enough blocks on their own threads. The
+// result is identical to the one from create_layout. The IType, its fonts, and
+// get_intrensic_size_for_resource_at_url are used from several threads at
+// once, so they all have to be thread-safe.
+std::optional<LayoutBox> create_layout_parallel(
+        style::StyledNode const &,
+        LayoutInfo const &,
+        type::IType const & = type::NaiveType{},
+        std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url =
+                [](std::string_view) { return std::nullopt; },
+        std::size_t max_threads = std::thread::hardware_concurrency());
+
+// Updates a layout created by create_layout from the same styled tree after
+// the nodes in `dirty` changed, e.g. by being restyled or by an image they
+// show being loaded. The closest block around each dirty node is created and
+// laid out again, while the rest of the tree keeps its boxes and is only
+// moved to where it ends up.
+void relayout(std::optional<LayoutBox> &,
+        style::StyledNode const &,
+        std::span<style::StyledNode const *const> dirty,
+        LayoutInfo const &,
+        type::IType const & = type::NaiveType{},
+        std::function<std::optional<Size>(std::string_view)> const &get_intrensic_size_for_resource_at_url =
+                [](std::string_view) { return std::nullopt; });
+
+// Lays out a styled tree a bit at a time so that the start of a very long
+// page can be shown w/o laying out all of it first. Blocks are laid out until
+// one starts below the requested position. The blocks after that have no
+// size or position, and their children aren't created until more of the page
+// is requested. The styled tree and the IType must outlive this.
+class LazyLayout {
+public:
+    // Lays out the first two viewports' worth of the page, so that it can be
+    // scrolled a bit before anything else has to be laid out.
+    LazyLayout(style::StyledNode const &,
+            LayoutInfo const &,
+            type::IType const &,
+            std::function<std::optional<Size>(std::string_view)> get_intrensic_size_for_resource_at_url =
+                    [](std::string_view) { return std::nullopt; });
+
+    // Lays out at least everything starting above `y`.
+    void layout_until(int y);
+    std::optional<LayoutBox> const &layout_all();
+
+    [[nodiscard]] bool is_complete() const { return stopped_at_.empty(); }
+    // The layout so far. See is_complete().
+    [[nodiscard]] std::optional<LayoutBox> const &layout() const { return layout_; }
+
+    // Lays out whatever could be at the position before looking for a box there.
+    LayoutBox const *box_at_position(geom::Position);
+
+private:
+    style::StyledNode const *root_{};
+    LayoutInfo info_;
+    type::IType const *type_{};
+    std::function<std::optional<Size>(std::string_view)> get_intrensic_size_for_resource_at_url_;
+    TextMeasurementCache local_text_measurements_;
+    std::optional<LayoutBox> layout_;
+    // Indices of the children to continue w/, from the root down.
+    std::vector<std::size_t> stopped_at_;
+    int laid_out_until_{};
+};
+
 } // namespace layout
 
 #endif
@@ -0,0 +1,430 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "layout/layout.h"
+
+#include "layout/box_index.h"
+#include "layout/layout_box.h"
+#include "layout/text_measurement_cache.h"
+
+#include "css/property_id.h"
+#include "dom/dom.h"
+#include "etest/etest2.h"
+#include "style/computed_style.h"
+#include "style/styled_node.h"
+#include "type/naive.h"
+#include "type/type.h"
+
+#include <nanobench.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+// nanobench doesn't count allocations, so every allocation in this binary is.
+std::atomic<std::size_t> allocations{};
+} // namespace
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto *ptr = std::malloc(size)) { // NOLINT(cppcoreguidelines-no-malloc)
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+namespace {
+void set_up_parent_ptrs(style::StyledNode &root) {
+    std::vector<style::StyledNode *> stack{&root};
+    while (!stack.empty()) {
+        auto *current = stack.back();
+        stack.pop_back();
+
+        for (auto &child : current->children) {
+            child.parent = current;
+            stack.push_back(&child);
+        }
+    }
+}
+
+// Like style_tree does. Uncomputed nodes look up what they inherit in their
+// ancestors, which makes layout of deeply nested documents quadratic in their
+// depth, and isn't what the engine lays out.
+void compute_styles(style::StyledNode &root, style::ComputedStyle::Cache &cache) {
+    std::vector<style::StyledNode *> stack{&root};
+    while (!stack.empty()) {
+        auto *current = stack.back();
+        stack.pop_back();
+
+        current->compute_properties(&cache);
+        for (auto &child : current->children) {
+            stack.push_back(&child);
+        }
+    }
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+style::StyledNode style_node(dom::Node const &node) {
+    style::StyledNode styled{.node{node}};
+    if (auto const *element = std::get_if<dom::Element>(&node)) {
+        if (element->name == "span") {
+            styled.properties = {
+                    {css::PropertyId::Display, "inline"},
+                    {css::PropertyId::TextTransform, "uppercase"},
+            };
+        } else if (element->name == "br" || element->name == "em") {
+            styled.properties = {{css::PropertyId::Display, "inline"}};
+        } else {
+            styled.properties = {{css::PropertyId::Display, "block"}};
+        }
+
+        for (auto const &child : element->children) {
+            styled.children.push_back(style_node(child));
+        }
+    }
+
+    return styled;
+}
+
+std::string make_paragraph(std::size_t words) {
+    static constexpr std::array kWords{"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit"};
+    std::string text;
+    for (std::size_t i = 0; i < words; ++i) {
+        if (i != 0) {
+            text += ' ';
+        }
+        text += kWords[i % kWords.size()];
+    }
+    return text;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+dom::Element make_sections(int width, int depth) {
+    dom::Element section{.name{"section"}};
+    for (int i = 0; i < width; ++i) {
+        if (depth == 1) {
+            section.children.emplace_back(dom::Element{.name{"p"}, .children{dom::Text{make_paragraph(50)}}});
+        } else {
+            section.children.emplace_back(make_sections(width, depth - 1));
+        }
+    }
+    return section;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::size_t count_boxes(layout::LayoutBox const &box) {
+    std::size_t boxes = 1;
+    for (auto const &child : box.children) {
+        boxes += count_boxes(child);
+    }
+    return boxes;
+}
+
+// Glyphs of different widths, roughly Helvetica's, where NaiveFont gives every
+// glyph the same width. The fonts from //type:sfml need a graphics context to
+// measure anything, which the benchmarks don't have. Layout only asks fonts for
+// the size of text, and w/ the measurements cached like in the benchmarks, it
+// doesn't ask again for text it has already measured, so what a real font
+// changes is where lines break. Varying the widths is enough for that.
+class ProportionalFont : public type::IFont {
+public:
+    type::Size measure(std::string_view text, type::Px font_size, type::Weight weight) const override {
+        int advance = 0;
+        for (auto c : text) {
+            advance += advance_of(c);
+        }
+
+        if (weight == type::Weight::Bold) {
+            advance += advance / 10;
+        }
+
+        return {advance * font_size.v / 1000, font_size.v};
+    }
+
+private:
+    // In thousandths of the font size.
+    static int advance_of(char c) {
+        switch (c) {
+            case ' ':
+            case 'f':
+            case 'i':
+            case 'j':
+            case 'l':
+            case 'r':
+            case 't':
+                return 280;
+            case 'm':
+            case 'w':
+                return 830;
+            default:
+                return c >= 'A' && c <= 'Z' ? 640 : 540;
+        }
+    }
+};
+
+class ProportionalType : public type::IType {
+public:
+    std::optional<std::shared_ptr<type::IFont const>> font(std::string_view) const override { return font_; }
+
+private:
+    std::shared_ptr<ProportionalFont const> font_{std::make_shared<ProportionalFont const>()};
+};
+
+dom::Node make_long_paragraph() {
+    dom::Element p{.name{"p"}, .children{dom::Text{make_paragraph(20'000)}}};
+    return dom::Element{.name{"html"}, .children{std::move(p)}};
+}
+
+dom::Node make_deep_nesting() {
+    dom::Element div{.name{"div"}, .children{dom::Text{make_paragraph(10)}}};
+    for (int i = 0; i < 500; ++i) {
+        div = dom::Element{.name{"div"}, .children{dom::Text{make_paragraph(10)}, std::move(div)}};
+    }
+    return dom::Element{.name{"html"}, .children{std::move(div)}};
+}
+
+dom::Node make_many_inline_elements() {
+    dom::Element p{.name{"p"}};
+    for (int i = 0; i < 5'000; ++i) {
+        p.children.emplace_back(dom::Element{.name{"em"}, .children{dom::Text{make_paragraph(3)}}});
+        p.children.emplace_back(dom::Text{" "});
+    }
+    return dom::Element{.name{"html"}, .children{std::move(p)}};
+}
+
+dom::Node make_many_brs() {
+    dom::Element p{.name{"p"}};
+    for (int i = 0; i < 10'000; ++i) {
+        p.children.emplace_back(dom::Text{make_paragraph(2)});
+        p.children.emplace_back(dom::Element{.name{"br"}});
+    }
+    return dom::Element{.name{"html"}, .children{std::move(p)}};
+}
+} // namespace
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("create_layout: long paragraph", [](etest::IActions const &) {
+        ankerl::nanobench::Bench bench;
+        bench.title("create_layout: long paragraph").relative(true);
+
+        type::NaiveType const type;
+        for (std::size_t words : {1'000, 4'000, 16'000}) {
+            dom::Node dom = dom::Element{.name{"html"}, .children{dom::Text{make_paragraph(words)}}};
+            style::StyledNode styled{
+                    .node{dom},
+                    .properties{{css::PropertyId::Display, "block"}, {css::PropertyId::FontSize, "16px"}},
+                    .children{style::StyledNode{.node{std::get<dom::Element>(dom).children[0]}}},
+            };
+            set_up_parent_ptrs(styled);
+
+            bench.run(std::format("{} words", words), [&] {
+                layout::TextMeasurementCache text_measurements;
+                auto layout = layout::create_layout(
+                        styled, {.viewport_width = 800, .text_measurements = &text_measurements}, type);
+                ankerl::nanobench::doNotOptimizeAway(layout);
+            });
+
+            layout::TextMeasurementCache text_measurements;
+            bench.run(std::format("{} words, cached measurements", words), [&] {
+                auto layout = layout::create_layout(
+                        styled, {.viewport_width = 800, .text_measurements = &text_measurements}, type);
+                ankerl::nanobench::doNotOptimizeAway(layout);
+            });
+        }
+    });
+
+    s.add_test("create_layout: scaling", [](etest::IActions const &) {
+        ankerl::nanobench::Bench bench;
+        bench.title("create_layout: scaling").unit("box");
+
+        type::NaiveType const naive;
+        ProportionalType const proportional;
+        std::array const types{std::pair<char const *, type::IType const *>{"naive font", &naive},
+                std::pair<char const *, type::IType const *>{"proportional font", &proportional}};
+
+        for (auto const &[document, make_dom] : {
+                     std::pair{"long paragraph", &make_long_paragraph},
+                     std::pair{"deep nesting", &make_deep_nesting},
+                     std::pair{"many inline elements", &make_many_inline_elements},
+                     std::pair{"many brs", &make_many_brs},
+             }) {
+            auto const dom = make_dom();
+            auto styled = style_node(dom);
+            set_up_parent_ptrs(styled);
+            style::ComputedStyle::Cache computed_styles;
+            compute_styles(styled, computed_styles);
+
+            for (auto const &[font, type] : types) {
+                layout::TextMeasurementCache text_measurements;
+                layout::LayoutInfo const info{.viewport_width = 800, .text_measurements = &text_measurements};
+                std::ignore = layout::create_layout(styled, info, *type);
+
+                // Counted w/ all text already measured, like in the benchmark.
+                auto const allocations_before = allocations.load();
+                auto const layout = layout::create_layout(styled, info, *type);
+                auto const allocated = allocations.load() - allocations_before;
+                auto const boxes = count_boxes(*layout);
+
+                auto const name = std::format("{}, {}", document, font);
+                bench.batch(boxes).run(name, [&] {
+                    ankerl::nanobench::doNotOptimizeAway(layout::create_layout(styled, info, *type));
+                });
+
+                std::cout << name << ": " << boxes << " boxes, " << allocated << " allocations\n";
+            }
+        }
+    });
+
+    s.add_test("create_layout: many paragraphs", [](etest::IActions const &) {
+        ankerl::nanobench::Bench bench;
+        bench.title("create_layout: many paragraphs");
+
+        // Lots of whitespace to collapse and text to transform.
+        dom::Element body{.name{"body"}};
+        for (int i = 0; i < 2'000; ++i) {
+            dom::Element p{.name{"p"}};
+            for (int j = 0; j < 5; ++j) {
+                p.children.emplace_back(dom::Text{"  some   text\n  "});
+                p.children.emplace_back(dom::Element{.name{"span"}, .children{dom::Text{" more  text "}}});
+            }
+            body.children.emplace_back(std::move(p));
+        }
+        dom::Node dom = dom::Element{.name{"html"}, .children{std::move(body)}};
+
+        auto styled = style_node(dom);
+        set_up_parent_ptrs(styled);
+
+        type::NaiveType const type;
+        layout::TextMeasurementCache text_measurements;
+        bench.run("create_layout", [&] {
+            auto layout = layout::create_layout(
+                    styled, {.viewport_width = 800, .text_measurements = &text_measurements}, type);
+            ankerl::nanobench::doNotOptimizeAway(layout);
+        });
+    });
+
+    s.add_test("LazyLayout: first screen of a long page", [](etest::IActions const &) {
+        ankerl::nanobench::Bench bench;
+        bench.title("LazyLayout: first screen of a long page").relative(true);
+
+        type::NaiveType const type;
+        for (int paragraphs : {1'000, 4'000, 16'000}) {
+            dom::Element body{.name{"body"}};
+            for (int i = 0; i < paragraphs; ++i) {
+                body.children.emplace_back(dom::Element{.name{"p"}, .children{dom::Text{make_paragraph(50)}}});
+            }
+            dom::Node dom = dom::Element{.name{"html"}, .children{std::move(body)}};
+
+            auto styled = style_node(dom);
+            set_up_parent_ptrs(styled);
+
+            layout::LayoutInfo const info{.viewport_width = 800, .viewport_height = 600};
+            bench.run(std::format("{} paragraphs, create_layout", paragraphs), [&] {
+                auto layout = layout::create_layout(styled, info, type);
+                ankerl::nanobench::doNotOptimizeAway(layout);
+            });
+
+            bench.run(std::format("{} paragraphs, LazyLayout", paragraphs), [&] {
+                layout::LazyLayout layout{styled, info, type};
+                ankerl::nanobench::doNotOptimizeAway(layout);
+            });
+        }
+    });
+
+    s.add_test("create_layout_parallel: wide and deep pages", [](etest::IActions const &) {
+        ankerl::nanobench::Bench bench;
+        bench.title("create_layout_parallel: wide and deep pages").relative(true);
+
+        // Lots of paragraphs next to each other.
+        dom::Element body{.name{"body"}};
+        for (int i = 0; i < 8'000; ++i) {
+            body.children.emplace_back(dom::Element{.name{"p"}, .children{dom::Text{make_paragraph(50)}}});
+        }
+        dom::Node wide = dom::Element{.name{"html"}, .children{std::move(body)}};
+
+        // Sections 4 wide and 6 deep w/ the paragraphs at the bottom.
+        dom::Node deep = dom::Element{.name{"html"}, .children{make_sections(4, 6)}};
+
+        type::NaiveType const type;
+        for (auto const &[name, dom] : {std::pair{"wide", &wide}, std::pair{"deep", &deep}}) {
+            auto styled = style_node(*dom);
+            set_up_parent_ptrs(styled);
+
+            bench.run(std::format("{}, create_layout", name), [&] {
+                layout::TextMeasurementCache text_measurements;
+                auto layout = layout::create_layout(
+                        styled, {.viewport_width = 800, .text_measurements = &text_measurements}, type);
+                ankerl::nanobench::doNotOptimizeAway(layout);
+            });
+
+            bench.run(std::format("{}, create_layout_parallel", name), [&] {
+                layout::TextMeasurementCache text_measurements;
+                auto layout = layout::create_layout_parallel(
+                        styled, {.viewport_width = 800, .text_measurements = &text_measurements}, type);
+                ankerl::nanobench::doNotOptimizeAway(layout);
+            });
+        }
+    });
+
+    s.add_test("box_at_position: long page", [](etest::IActions const &) {
+        ankerl::nanobench::Bench bench;
+        bench.title("box_at_position: long page").relative(true);
+
+        dom::Element body{.name{"body"}};
+        for (int i = 0; i < 4'000; ++i) {
+            body.children.emplace_back(dom::Element{.name{"p"}, .children{dom::Text{make_paragraph(50)}}});
+        }
+        dom::Node dom = dom::Element{.name{"html"}, .children{std::move(body)}};
+
+        auto styled = style_node(dom);
+        set_up_parent_ptrs(styled);
+
+        type::NaiveType const type;
+        auto const layout = layout::create_layout(styled, {.viewport_width = 800}, type).value();
+        auto const bottom = layout.dimensions.content.height.round();
+
+        int y = 0;
+        bench.run("box_at_position", [&] {
+            y = (y + 997) % bottom;
+            ankerl::nanobench::doNotOptimizeAway(layout::box_at_position(layout, {400, y}));
+        });
+
+        layout::BoxIndex const index{layout};
+        bench.run("BoxIndex::box_at_position", [&] {
+            y = (y + 997) % bottom;
+            ankerl::nanobench::doNotOptimizeAway(index.box_at_position({400, y}));
+        });
+
+        bench.run("BoxIndex::boxes_in", [&] {
+            y = (y + 997) % bottom;
+            ankerl::nanobench::doNotOptimizeAway(index.boxes_in({0, y, 800, 600}));
+        });
+    });
+
+    return s.run();
+}
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -41,12 +41,23 @@ std::string_view layout_type(LayoutBox const &box) {
     return "block";
 }
 
-std::string to_str(geom::Rect const &rect) {
-    return std::format("{{{},{},{},{}}}", rect.x, rect.y, rect.width, rect.height);
+// Whole pixels are printed w/o any decimals.
+std::string to_str(geom::LayoutUnit unit) {
+    if (unit.raw() % geom::LayoutUnit::kSubpixels == 0) {
+        return std::to_string(unit.floor());
+    }
+
+    return std::format("{}", unit.to_float());
+}
+
+std::string to_str(geom::LayoutRect const &rect) {
+    return std::format(
+            "{{{},{},{},{}}}", to_str(rect.x), to_str(rect.y), to_str(rect.width), to_str(rect.height));
 }
 
-std::string to_str(geom::EdgeSize const &edge) {
-    return std::format("{{{},{},{},{}}}", edge.top, edge.right, edge.bottom, edge.left);
+std::string to_str(geom::LayoutEdgeSize const &edge) {
+    return std::format(
+            "{{{},{},{},{}}}", to_str(edge.top), to_str(edge.right), to_str(edge.bottom), to_str(edge.left));
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
@@ -83,6 +94,7 @@ std::optional<std::string_view> LayoutBox::text() const {
         std::optional<std::string_view> operator()(std::monostate) { return std::nullopt; }
         std::optional<std::string_view> operator()(std::string const &s) { return s; }
         std::optional<std::string_view> operator()(std::string_view const &s) { return s; }
+        std::optional<std::string_view> operator()(TextSlice const &s) { return s.text; }
     };
     return std::visit(Visitor{}, layout_text);
 }
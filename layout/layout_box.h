@@ -13,6 +13,7 @@
 #include "style/styled_node.h"
 
 #include <cassert>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -21,14 +22,26 @@
 
 namespace layout {
 
+// A line of text the layout had to create, e.g. by collapsing whitespace,
+// that's been split over several lines. All the lines share the string.
+struct TextSlice {
+    std::shared_ptr<std::string const> owner;
+    std::string_view text;
+};
+
 // NOLINTNEXTLINE(misc-no-recursion)
 struct LayoutBox {
     style::StyledNode const *node;
     BoxModel dimensions;
     std::vector<LayoutBox> children;
-    std::variant<std::monostate, std::string_view, std::string> layout_text;
+    std::variant<std::monostate, std::string_view, std::string, TextSlice> layout_text;
+
+    // Boxes w/ the same text are equal no matter how the text is stored.
     // NOLINTNEXTLINE(misc-no-recursion)
-    [[nodiscard]] bool operator==(LayoutBox const &) const = default;
+    [[nodiscard]] bool operator==(LayoutBox const &other) const {
+        return node == other.node && dimensions == other.dimensions && children == other.children
+                && text() == other.text();
+    }
 
     bool is_anonymous_block() const { return node == nullptr; }
     std::optional<std::string_view> text() const;
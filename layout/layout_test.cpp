@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -6,6 +6,7 @@
 #include "layout/layout.h"
 
 #include "layout/layout_box.h"
+#include "layout/text_measurement_cache.h"
 
 #include "css/property_id.h"
 #include "dom/dom.h"
@@ -400,6 +401,71 @@ void whitespace_collapsing_tests(etest::Suite &s) {
         a.expect_eq(actual, expected_layout);
     });
 
+    s.add_test("whitespace collapsing: whitespace before a block element", [](etest::IActions &a) {
+        dom::Node html = dom::Element{
+                .name{"html"},
+                .children{
+                        dom::Element{.name{"span"}, .children{dom::Text{"hello"}}},
+                        dom::Text{"   "},
+                        dom::Element{.name{"p"}},
+                        dom::Text{"   "},
+                },
+        };
+        auto const &html_element = std::get<dom::Element>(html);
+        auto const &span = std::get<dom::Element>(html_element.children.at(0));
+
+        style::StyledNode style{
+                .node{html},
+                .properties{
+                        {css::PropertyId::Display, "block"},
+                        {css::PropertyId::FontSize, "10px"},
+                        {css::PropertyId::LineHeight, "1"},
+                },
+                .children{
+                        style::StyledNode{
+                                .node{html_element.children.at(0)},
+                                .properties{{css::PropertyId::Display, "inline"}},
+                                .children{style::StyledNode{span.children.at(0)}},
+                        },
+                        style::StyledNode{html_element.children.at(1)},
+                        style::StyledNode{
+                                .node{html_element.children.at(2)},
+                                .properties{{css::PropertyId::Display, "block"}},
+                        },
+                        style::StyledNode{html_element.children.at(3)},
+                },
+        };
+        set_up_parent_ptrs(style);
+
+        // The whitespace is dropped, taking the anonymous block it would've been in w/ it.
+        layout::LayoutBox expected_layout{
+                .node = &style,
+                .dimensions{{0, 0, 100, 10}},
+                .children{
+                        layout::LayoutBox{
+                                .node = nullptr,
+                                .dimensions{{0, 0, 100, 10}},
+                                .children{layout::LayoutBox{
+                                        .node = &style.children.at(0),
+                                        .dimensions{{0, 0, 25, 10}},
+                                        .children{layout::LayoutBox{
+                                                .node = &style.children.at(0).children.at(0),
+                                                .dimensions{{0, 0, 25, 10}},
+                                                .layout_text{"hello"sv},
+                                        }},
+                                }},
+                        },
+                        layout::LayoutBox{
+                                .node = &style.children.at(2),
+                                .dimensions{{0, 10, 100, 0}},
+                        },
+                },
+        };
+
+        auto actual = layout::create_layout(style, {.viewport_width = 100});
+        a.expect_eq(actual, expected_layout);
+    });
+
     s.add_test("whitespace collapsing: <p>hello</p>   <p>world</p>", [](etest::IActions &a) {
         constexpr auto kFirstText = "hello"sv;
         constexpr auto kSecondText = "world"sv;
@@ -770,6 +836,59 @@ void img_tests(etest::Suite &s) {
         a.expect_eq(expected_layout.children.at(0).text(), "hello");
     });
 
+    s.add_test("img, empty alt, white-space: pre", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{"body", {}, {dom::Element{"img", {{"alt", ""}}}}};
+        auto const &body = std::get<dom::Element>(dom);
+        auto style = style::StyledNode{
+                .node = dom,
+                .properties{
+                        {css::PropertyId::Display, "block"},
+                        {css::PropertyId::FontSize, "10px"},
+                        {css::PropertyId::WhiteSpace, "pre"},
+                },
+                .children{
+                        {body.children.at(0), {{css::PropertyId::Display, "inline"}}},
+                },
+        };
+        set_up_parent_ptrs(style);
+
+        auto layout_root = layout::create_layout(style, {.viewport_width = 100});
+        a.require(layout_root.has_value());
+        a.expect(layout_root->children.empty());
+    });
+
+    s.add_test("block img, alt collapsing to nothing", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{
+                "body",
+                {},
+                {dom::Text{"a "}, dom::Element{"img", {{"alt", " "}}}, dom::Text{"b"}},
+        };
+        auto const &body = std::get<dom::Element>(dom);
+        auto style = style::StyledNode{
+                .node = dom,
+                .properties{
+                        {css::PropertyId::Display, "block"},
+                        {css::PropertyId::FontSize, "10px"},
+                },
+                .children{
+                        {body.children.at(0)},
+                        {body.children.at(1), {{css::PropertyId::Display, "block"}}},
+                        {body.children.at(2)},
+                },
+        };
+        set_up_parent_ptrs(style);
+
+        // The img is gone, but the text on either side of it still ends up in
+        // different anonymous blocks, and the text before it ends its line.
+        auto layout_root = layout::create_layout(style, {.viewport_width = 100});
+        a.require(layout_root.has_value());
+        a.require_eq(layout_root->children.size(), std::size_t{2});
+        a.expect(layout_root->children[0].is_anonymous_block());
+        a.expect(layout_root->children[1].is_anonymous_block());
+        a.expect_eq(layout_root->children[0].children.at(0).text(), "a"sv);
+        a.expect_eq(layout_root->children[1].children.at(0).text(), "b"sv);
+    });
+
     // TODO(robinlinden): This test should break when we implement more of image layouting.
     s.add_test("img, alt, src", [](etest::IActions &a) {
         dom::Node dom = dom::Element{"body", {}, {dom::Element{"img", {{"alt", "asdf"}, {"src", "hallo"}}}}};
@@ -870,6 +989,337 @@ void img_tests(etest::Suite &s) {
     });
 }
 
+void relayout_tests(etest::Suite &s) {
+    // <body><div>first</div><p><img alt="hello" src="img.png"></p><div>last</div></body>
+    struct Page {
+        dom::Node dom = dom::Element{
+                "body",
+                {},
+                {
+                        dom::Element{"div", {}, {dom::Text{"first"}}},
+                        dom::Element{"p", {}, {dom::Element{"img", {{"alt", "hello"}, {"src", "img.png"}}}}},
+                        dom::Element{"div", {}, {dom::Text{"last"}}},
+                },
+        };
+        style::StyledNode style = [this] {
+            auto const &body = std::get<dom::Element>(dom).children;
+            auto const &first = std::get<dom::Element>(body.at(0)).children;
+            auto const &p = std::get<dom::Element>(body.at(1)).children;
+            auto const &last = std::get<dom::Element>(body.at(2)).children;
+            auto styled = style::StyledNode{
+                    .node = dom,
+                    .properties{
+                            {css::PropertyId::Display, "block"},
+                            {css::PropertyId::FontSize, "10px"},
+                            {css::PropertyId::LineHeight, "1"},
+                    },
+                    .children{
+                            {body.at(0), {{css::PropertyId::Display, "block"}}, {{first.at(0)}}},
+                            {body.at(1),
+                                    {{css::PropertyId::Display, "block"}},
+                                    {{p.at(0), {{css::PropertyId::Display, "inline"}}}}},
+                            {body.at(2), {{css::PropertyId::Display, "block"}}, {{last.at(0)}}},
+                    },
+            };
+            set_up_parent_ptrs(styled);
+            return styled;
+        }();
+    };
+
+    s.add_test("relayout: image loaded", [](etest::IActions &a) {
+        Page page;
+        std::optional<layout::Size> image_size;
+        auto get_size = [&](std::string_view) { return image_size; };
+
+        auto layout = layout::create_layout(page.style, {.viewport_width = 100}, type::NaiveType{}, get_size);
+        a.require(layout.has_value());
+        a.expect_eq(layout->children.at(1).children.at(0).children.at(0).text(), "hello"sv);
+        auto const *last_box = &layout->children.at(2);
+
+        image_size = layout::Size{20, 30};
+        style::StyledNode const *dirty[] = {&page.style.children.at(1).children.at(0)};
+        layout::relayout(layout, page.style, dirty, {.viewport_width = 100}, type::NaiveType{}, get_size);
+
+        a.expect_eq(layout, layout::create_layout(page.style, {.viewport_width = 100}, type::NaiveType{}, get_size));
+        // The image got its size, and the boxes after it were moved down rather than recreated.
+        a.expect_eq(layout->children.at(1).children.at(0).children.at(0).dimensions.content,
+                geom::LayoutRect{0, 10, 20, 30});
+        a.expect_eq(layout->children.at(2).dimensions.content.y, 40);
+        a.expect_eq(&layout->children.at(2), last_box);
+    });
+
+    s.add_test("relayout: block restyled", [](etest::IActions &a) {
+        Page page;
+        auto layout = layout::create_layout(page.style, {.viewport_width = 100});
+
+        auto &first = page.style.children.at(0);
+        first.properties.emplace_back(css::PropertyId::Height, "50px");
+        first.properties.emplace_back(css::PropertyId::PaddingLeft, "5px");
+        style::StyledNode const *dirty[] = {&first};
+        layout::relayout(layout, page.style, dirty, {.viewport_width = 100});
+
+        a.expect_eq(layout, layout::create_layout(page.style, {.viewport_width = 100}));
+        a.expect_eq(layout->children.at(0).dimensions.content, geom::LayoutRect{5, 0, 95, 50});
+        a.expect_eq(layout->children.at(2).dimensions.content.y, 60);
+    });
+
+    s.add_test("relayout: block becoming inline", [](etest::IActions &a) {
+        Page page;
+        auto layout = layout::create_layout(page.style, {.viewport_width = 100});
+
+        auto &last = page.style.children.at(2);
+        last.properties = {{css::PropertyId::Display, "inline"}};
+        style::StyledNode const *dirty[] = {&last};
+        layout::relayout(layout, page.style, dirty, {.viewport_width = 100});
+
+        a.expect_eq(layout, layout::create_layout(page.style, {.viewport_width = 100}));
+        a.expect(layout->children.at(2).is_anonymous_block());
+    });
+
+    s.add_test("relayout: block img w/ alt text next to text", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{
+                "body",
+                {},
+                {dom::Text{"x x "}, dom::Element{"img", {{"alt", " y"}, {"src", "img.png"}}}},
+        };
+        auto const &body = std::get<dom::Element>(dom);
+        style::StyledNode style{
+                .node = dom,
+                .properties{
+                        {css::PropertyId::Display, "block"},
+                        {css::PropertyId::FontSize, "10px"},
+                },
+                .children{{body.children.at(0)}, {body.children.at(1), {{css::PropertyId::Display, "block"}}}},
+        };
+        set_up_parent_ptrs(style);
+
+        std::optional<layout::Size> image_size;
+        auto get_size = [&](std::string_view) { return image_size; };
+        layout::LayoutInfo const info{.viewport_width = 100};
+        auto layout = layout::create_layout(style, info, type::NaiveType{}, get_size);
+        a.require(layout.has_value());
+        a.expect_eq(layout->children.at(0).children.at(0).text(), "x x"sv);
+        a.expect_eq(layout->children.at(1).text(), "y"sv);
+
+        // The text before the img doesn't depend on what the img shows.
+        style::StyledNode const *dirty[] = {&style.children.at(1)};
+        image_size = layout::Size{20, 30};
+        layout::relayout(layout, style, dirty, info, type::NaiveType{}, get_size);
+        a.expect_eq(layout, layout::create_layout(style, info, type::NaiveType{}, get_size));
+        a.expect_eq(layout->children.at(1).text(), std::nullopt);
+
+        // The alt text is back when the image is gone again.
+        image_size = std::nullopt;
+        layout::relayout(layout, style, dirty, info, type::NaiveType{}, get_size);
+        a.expect_eq(layout, layout::create_layout(style, info, type::NaiveType{}, get_size));
+        a.expect_eq(layout->children.at(1).text(), "y"sv);
+    });
+
+    s.add_test("relayout: nothing dirty", [](etest::IActions &a) {
+        Page page;
+        auto layout = layout::create_layout(page.style, {.viewport_width = 100});
+        auto const expected = layout;
+
+        layout::relayout(layout, page.style, {}, {.viewport_width = 100});
+        a.expect_eq(layout, expected);
+    });
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+style::StyledNode style_as_blocks(dom::Node const &node) {
+    style::StyledNode styled{.node{node}};
+    if (auto const *element = std::get_if<dom::Element>(&node)) {
+        styled.properties = {{css::PropertyId::Display, "block"}};
+        for (auto const &child : element->children) {
+            styled.children.push_back(style_as_blocks(child));
+        }
+    }
+
+    return styled;
+}
+
+void lazy_layout_tests(etest::Suite &s) {
+    // <html><section><div>0</div>...<div>19</div></section><div>20</div>...<div>39</div></html>
+    // Every div is 10px tall, so the html element is 400px tall in total.
+    struct Page {
+        dom::Node dom = [] {
+            dom::Element section{"section"};
+            dom::Element html{"html"};
+            for (int i = 0; i < 40; ++i) {
+                auto &parent = i < 20 ? section : html;
+                parent.children.emplace_back(dom::Element{"div", {}, {dom::Text{std::to_string(i)}}});
+                if (i == 19) {
+                    html.children.emplace_back(std::move(section));
+                }
+            }
+            return html;
+        }();
+        style::StyledNode style = [this] {
+            auto styled = style_as_blocks(dom);
+            styled.properties.emplace_back(css::PropertyId::FontSize, "10px");
+            styled.properties.emplace_back(css::PropertyId::LineHeight, "1");
+            set_up_parent_ptrs(styled);
+            return styled;
+        }();
+    };
+
+    s.add_test("lazy layout: the first viewports", [](etest::IActions &a) {
+        Page page;
+        type::NaiveType const type;
+        layout::LayoutInfo const info{.viewport_width = 100, .viewport_height = 50};
+        layout::LazyLayout lazy{page.style, info, type};
+        a.expect(!lazy.is_complete());
+
+        // Everything starting in the first 100px is laid out.
+        auto const &section = lazy.layout()->children.at(0);
+        a.expect_eq(section.children.at(10).dimensions.content, geom::LayoutRect{0, 100, 100, 10});
+        a.expect_eq(section.children.at(11).dimensions.content, geom::LayoutRect{});
+        a.expect_eq(lazy.layout()->dimensions.content.height, 110);
+
+        a.expect_eq(lazy.layout_all(), layout::create_layout(page.style, info, type));
+        a.expect(lazy.is_complete());
+    });
+
+    s.add_test("lazy layout: laying out more", [](etest::IActions &a) {
+        Page page;
+        type::NaiveType const type;
+        layout::LayoutInfo const info{.viewport_width = 100, .viewport_height = 50};
+        layout::LazyLayout lazy{page.style, info, type};
+
+        // Asking for less than what's already there does nothing.
+        auto const before = lazy.layout();
+        lazy.layout_until(50);
+        a.expect_eq(lazy.layout(), before);
+
+        lazy.layout_until(150);
+        auto const &section = lazy.layout()->children.at(0);
+        a.expect_eq(section.children.at(15).dimensions.content.y, 150);
+        a.expect_eq(section.children.at(16).dimensions.content, geom::LayoutRect{});
+
+        // Continuing past the end of the section.
+        lazy.layout_until(300);
+        auto const &html = *lazy.layout();
+        a.expect_eq(section.dimensions.content.height, 200);
+        a.expect_eq(html.children.at(11).dimensions.content.y, 300);
+        a.expect_eq(html.children.at(12).dimensions.content, geom::LayoutRect{});
+        a.expect(!lazy.is_complete());
+
+        auto const *last = lazy.box_at_position({5, 395});
+        a.require(last != nullptr);
+        a.expect_eq(last->text(), "39"sv);
+        a.expect(lazy.is_complete());
+        a.expect_eq(lazy.layout(), layout::create_layout(page.style, info, type));
+    });
+
+    s.add_test("lazy layout: blocks in inlines", [](etest::IActions &a) {
+        // <html><span><div><p>lost</p></div></span></html>
+        dom::Node const dom = dom::Element{
+                "html",
+                {},
+                {dom::Element{"span", {}, {dom::Element{"div", {}, {dom::Element{"p", {}, {dom::Text{"lost"}}}}}}}},
+        };
+        auto style = style_as_blocks(dom);
+        style.properties.emplace_back(css::PropertyId::FontSize, "10px");
+        style.children.at(0).properties = {{css::PropertyId::Display, "inline"}};
+        set_up_parent_ptrs(style);
+
+        type::NaiveType const type;
+        layout::LayoutInfo const info{.viewport_width = 100, .viewport_height = 50};
+        layout::LazyLayout lazy{style, info, type};
+        auto const &span = lazy.layout()->children.at(0).children.at(0);
+        auto const &p = span.children.at(0).children.at(0);
+        a.expect_eq(p.children.at(0).children.at(0).text(), "lost"sv);
+        a.expect_eq(lazy.layout_all(), layout::create_layout(style, info, type));
+    });
+
+    s.add_test("lazy layout: text before a block w/ text", [](etest::IActions &a) {
+        // <html><div><p>a </p><img alt=" b"></div>...</html>, w/ a block-level img.
+        dom::Element html{"html"};
+        for (int i = 0; i < 20; ++i) {
+            html.children.emplace_back(dom::Element{
+                    "div",
+                    {},
+                    {dom::Element{"p", {}, {dom::Text{"a "}}}, dom::Element{"img", {{"alt", " b"}}}},
+            });
+        }
+        dom::Node const dom = std::move(html);
+        auto style = style_as_blocks(dom);
+        style.properties.emplace_back(css::PropertyId::FontSize, "10px");
+        set_up_parent_ptrs(style);
+
+        // The block ends the text before it, no matter when that text's built.
+        type::NaiveType const type;
+        layout::LayoutInfo const info{.viewport_width = 100, .viewport_height = 10};
+        layout::LazyLayout lazy{style, info, type};
+        auto const &expected = layout::create_layout(style, info, type);
+        a.require(expected.has_value());
+        auto const &last_div = expected->children.back();
+        a.expect_eq(last_div.children.at(0).children.at(0).children.at(0).text(), "a"sv);
+        a.expect_eq(last_div.children.at(1).text(), "b"sv);
+        a.expect_eq(lazy.layout_all(), expected);
+    });
+}
+
+void parallel_layout_tests(etest::Suite &s) {
+    static constexpr auto kNoImages = [](std::string_view) -> std::optional<layout::Size> { return std::nullopt; };
+
+    s.add_test("create_layout_parallel: same result as create_layout", [](etest::IActions &a) {
+        // A few large subtrees, and a long list that has to be split up.
+        dom::Element body{"body"};
+        for (int i = 0; i < 4; ++i) {
+            dom::Element section{"section"};
+            for (int j = 0; j < 300; ++j) {
+                auto text = std::string(j % 11 * 3, 'a') + " b c";
+                section.children.emplace_back(dom::Element{"p", {}, {dom::Text{std::move(text)}}});
+            }
+            body.children.emplace_back(std::move(section));
+        }
+        for (int i = 0; i < 2000; ++i) {
+            body.children.emplace_back(dom::Element{"div", {}, {dom::Text{"hello world"}}});
+        }
+        dom::Node const dom = dom::Element{"html", {}, {std::move(body)}};
+
+        auto styled = style_as_blocks(dom);
+        styled.properties.emplace_back(css::PropertyId::FontSize, "10px");
+        auto &sections = styled.children.at(0).children;
+        sections.at(1).properties.emplace_back(css::PropertyId::Width, "50px");
+        sections.at(1).properties.emplace_back(css::PropertyId::PaddingTop, "3px");
+        sections.at(2).properties.emplace_back(css::PropertyId::MarginLeft, "7px");
+        for (auto &p : sections.at(3).children) {
+            p.properties.emplace_back(css::PropertyId::BorderBottomStyle, "solid");
+            p.properties.emplace_back(css::PropertyId::BorderBottomWidth, "2px");
+        }
+        set_up_parent_ptrs(styled);
+
+        type::NaiveType const type;
+        layout::LayoutInfo const info{.viewport_width = 100, .viewport_height = 100};
+        auto const expected = layout::create_layout(styled, info, type);
+        for (std::size_t threads : {1, 2, 3, 16}) {
+            auto const l = layout::create_layout_parallel(styled, info, type, kNoImages, threads);
+            a.expect_eq(l, expected);
+        }
+    });
+
+    s.add_test("create_layout_parallel: text measurements are kept", [](etest::IActions &a) {
+        dom::Element html{"html"};
+        for (int i = 0; i < 3000; ++i) {
+            html.children.emplace_back(dom::Element{"p", {}, {dom::Text{std::to_string(i)}}});
+        }
+        dom::Node const dom = std::move(html);
+        auto styled = style_as_blocks(dom);
+        set_up_parent_ptrs(styled);
+
+        type::NaiveType const type;
+        layout::TextMeasurementCache text_measurements;
+        layout::LayoutInfo const info{.viewport_width = 100, .text_measurements = &text_measurements};
+        auto const l = layout::create_layout_parallel(styled, info, type, kNoImages, 4);
+        a.expect_eq(text_measurements.size(), std::size_t{3000});
+
+        a.expect_eq(layout::create_layout_parallel(styled, info, type, kNoImages, 4), l);
+        a.expect_eq(text_measurements.size(), std::size_t{3000});
+    });
+}
+
 } // namespace
 
 int main() {
@@ -2190,7 +2640,7 @@ int main() {
         };
 
         auto layout = layout::create_layout(style, {.viewport_width = 0}).value();
-        a.expect_eq(layout.dimensions.border, geom::EdgeSize{.left = 3});
+        a.expect_eq(layout.dimensions.border, geom::LayoutEdgeSize{.left = 3});
     });
 
     s.add_test("text, bold", [](etest::IActions &a) {
@@ -2295,8 +2745,6 @@ int main() {
         };
         set_up_parent_ptrs(style);
 
-        // TODO(robinlinden): It should be possible for the text here to be
-        // views into the dom text.
         layout::LayoutBox expected{
                 .node = &style,
                 // 2 lines, where the widest one is 5 characters.
@@ -2308,12 +2756,12 @@ int main() {
                                 layout::LayoutBox{
                                         .node = &style.children[0],
                                         .dimensions{{0, 0, 10, 10}},
-                                        .layout_text = "hi"s,
+                                        .layout_text = "hi"sv,
                                 },
                                 layout::LayoutBox{
                                         .node = &style.children[0],
                                         .dimensions{{0, 10, 25, 10}},
-                                        .layout_text = "hello"s,
+                                        .layout_text = "hello"sv,
                                 },
                         },
                 }},
@@ -2346,12 +2794,12 @@ int main() {
                                 layout::LayoutBox{
                                         .node = &style.children[0],
                                         .dimensions{{0, 0, 25, 10}},
-                                        .layout_text = "oh no"s,
+                                        .layout_text = "oh no"sv,
                                 },
                                 layout::LayoutBox{
                                         .node = &style.children[0],
                                         .dimensions{{0, 10, 20, 10}},
-                                        .layout_text = "!! !"s,
+                                        .layout_text = "!! !"sv,
                                 },
                         },
                 }},
@@ -2361,6 +2809,118 @@ int main() {
         a.expect_eq(l, expected);
     });
 
+    s.add_test("text too long for its container, many lines", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{.name{"html"}, .children{dom::Text{"a bb ccc dd e ffffff g"}}};
+        style::StyledNode style{
+                .node{dom},
+                .properties{
+                        {css::PropertyId::Display, "block"},
+                        {css::PropertyId::FontSize, "10px"},
+                        {css::PropertyId::LineHeight, "1"},
+                },
+                .children{style::StyledNode{.node{std::get<dom::Element>(dom).children[0]}}},
+        };
+        set_up_parent_ptrs(style);
+
+        auto line = [&](int y, int width, std::string_view text) {
+            return layout::LayoutBox{
+                    .node = &style.children[0],
+                    .dimensions{{0, y, width, 10}},
+                    .layout_text = text,
+            };
+        };
+
+        // The 6 character word doesn't fit on a line of its own, so
+        // everything after it ends up on the same line.
+        layout::LayoutBox expected{
+                .node = &style,
+                .dimensions{{0, 0, 25, 40}},
+                .children{layout::LayoutBox{
+                        .node = nullptr,
+                        .dimensions{{0, 0, 25, 40}},
+                        .children{
+                                line(0, 20, "a bb"),
+                                line(10, 15, "ccc"),
+                                line(20, 20, "dd e"),
+                                line(30, 40, "ffffff g"),
+                        },
+                }},
+        };
+
+        type::NaiveType const type;
+        layout::TextMeasurementCache text_measurements;
+        auto l = layout::create_layout(style, {.viewport_width = 25, .text_measurements = &text_measurements}, type);
+        a.expect_eq(l, expected);
+        a.expect(text_measurements.size() > 0);
+
+        // Laying things out again w/ everything cached gives the same result.
+        auto const cached = text_measurements.size();
+        l = layout::create_layout(style, {.viewport_width = 25, .text_measurements = &text_measurements}, type);
+        a.expect_eq(l, expected);
+        a.expect_eq(text_measurements.size(), cached);
+    });
+
+    s.add_test("text too long for its container, transformed text", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{.name{"html"}, .children{dom::Text{"aa bb  cc"}}};
+        style::StyledNode style{
+                .node{dom},
+                .properties{
+                        {css::PropertyId::Display, "block"},
+                        {css::PropertyId::FontSize, "10px"},
+                        {css::PropertyId::LineHeight, "1"},
+                        {css::PropertyId::TextTransform, "uppercase"},
+                },
+                .children{style::StyledNode{.node{std::get<dom::Element>(dom).children[0]}}},
+        };
+        set_up_parent_ptrs(style);
+
+        // The text is no longer a view into the DOM, so the lines share a string owned by the layout.
+        layout::LayoutBox expected{
+                .node = &style,
+                .dimensions{{0, 0, 10, 30}},
+                .children{layout::LayoutBox{
+                        .node = nullptr,
+                        .dimensions{{0, 0, 10, 30}},
+                        .children{
+                                layout::LayoutBox{
+                                        .node = &style.children[0],
+                                        .dimensions{{0, 0, 10, 10}},
+                                        .layout_text = "AA"s,
+                                },
+                                layout::LayoutBox{
+                                        .node = &style.children[0],
+                                        .dimensions{{0, 10, 10, 10}},
+                                        .layout_text = "BB"s,
+                                },
+                                layout::LayoutBox{
+                                        .node = &style.children[0],
+                                        .dimensions{{0, 20, 10, 10}},
+                                        .layout_text = "CC"s,
+                                },
+                        },
+                }},
+        };
+
+        auto l = layout::create_layout(style, {.viewport_width = 10}).value();
+        a.expect_eq(l, expected);
+
+        auto const &lines = l.children.at(0).children;
+        a.require_eq(lines.size(), std::size_t{3});
+        auto const *first = std::get_if<layout::TextSlice>(&lines[0].layout_text);
+        a.require(first != nullptr);
+        a.expect_eq(*first->owner, "AA BB CC");
+        for (auto const &line : lines) {
+            auto const *slice = std::get_if<layout::TextSlice>(&line.layout_text);
+            a.require(slice != nullptr);
+            a.expect_eq(slice->owner, first->owner);
+        }
+
+        // Copies of the layout still point into the same string.
+        auto const copy = l;
+        a.expect_eq(copy, expected);
+        a.expect_eq(std::get<layout::TextSlice>(copy.children[0].children[2].layout_text).owner, first->owner);
+    });
+
     s.add_test("unsplittable text too long for its container, short text after", [](etest::IActions &a) {
         dom::Node dom = dom::Element{
                 .name{"html"},
@@ -2881,9 +3441,41 @@ int main() {
         a.expect_eq(l, expected);
     });
 
+    s.add_test("fractions of pixels add up", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{"html", {}, {dom::Element{"div"}, dom::Element{"div"}, dom::Element{"div"}}};
+        auto const &children = std::get<dom::Element>(dom).children;
+        auto const div_properties = std::vector<std::pair<css::PropertyId, std::string>>{
+                {css::PropertyId::Display, "block"},
+                {css::PropertyId::Width, "12.5%"},
+                {css::PropertyId::Height, "10.25px"},
+        };
+        style::StyledNode style{
+                .node{dom},
+                .properties{{css::PropertyId::Display, "block"}},
+                .children{
+                        style::StyledNode{.node{children[0]}, .properties{div_properties}},
+                        style::StyledNode{.node{children[1]}, .properties{div_properties}},
+                        style::StyledNode{.node{children[2]}, .properties{div_properties}},
+                },
+        };
+        set_up_parent_ptrs(style);
+
+        auto const l = layout::create_layout(style, {.viewport_width = 100}).value();
+        auto const quarter = geom::LayoutUnit::from_raw(geom::LayoutUnit::kSubpixels / 4);
+        auto const half = geom::LayoutUnit::from_raw(geom::LayoutUnit::kSubpixels / 2);
+        a.expect_eq(l.children.at(0).dimensions.content, geom::LayoutRect{0, 0, 12 + half, 10 + quarter});
+        a.expect_eq(l.children.at(1).dimensions.content.y, 10 + quarter);
+        a.expect_eq(l.children.at(2).dimensions.content.y, 20 + half);
+        a.expect_eq(l.dimensions.content.height, 30 + 3 * quarter);
+        a.expect_eq(geom::snapped(l.children.at(2).dimensions.content), geom::Rect{0, 21, 13, 10});
+    });
+
     whitespace_collapsing_tests(s);
     text_transform_tests(s);
     img_tests(s);
+    relayout_tests(s);
+    lazy_layout_tests(s);
+    parallel_layout_tests(s);
 
     return s.run();
 }
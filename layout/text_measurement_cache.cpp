@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "layout/text_measurement_cache.h"
+
+#include "type/type.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace layout {
+
+type::Size TextMeasurementCache::measure(std::shared_ptr<type::IFont const> const &font,
+        std::string_view text,
+        type::Px font_size,
+        type::Weight weight) {
+    KeyView key{font.get(), font_size.v, weight, text};
+    if (shared_ != nullptr) {
+        if (auto it = shared_->measurements_.find(key); it != shared_->measurements_.end()) {
+            return it->second;
+        }
+    }
+
+    if (auto it = measurements_.find(key); it != measurements_.end()) {
+        return it->second;
+    }
+
+    fonts_.insert(font);
+    auto size = font->measure(text, font_size, weight);
+    measurements_.emplace(Key{font.get(), font_size.v, weight, std::string{text}}, size);
+    return size;
+}
+
+std::vector<int> const &TextMeasurementCache::word_ends(std::shared_ptr<type::IFont const> const &font,
+        std::string_view text,
+        type::Px font_size,
+        type::Weight weight) {
+    KeyView key{font.get(), font_size.v, weight, text};
+    if (shared_ != nullptr) {
+        if (auto it = shared_->word_ends_.find(key); it != shared_->word_ends_.end()) {
+            return it->second;
+        }
+    }
+
+    if (auto it = word_ends_.find(key); it != word_ends_.end()) {
+        return it->second;
+    }
+
+    fonts_.insert(font);
+    auto ends = font->word_ends(text, font_size, weight);
+    return word_ends_.emplace(Key{font.get(), font_size.v, weight, std::string{text}}, std::move(ends)).first->second;
+}
+
+void TextMeasurementCache::clear() {
+    measurements_.clear();
+    word_ends_.clear();
+    fonts_.clear();
+}
+
+void TextMeasurementCache::merge(TextMeasurementCache &&other) {
+    fonts_.merge(other.fonts_);
+    measurements_.merge(other.measurements_);
+    word_ends_.merge(other.word_ends_);
+}
+
+} // namespace layout
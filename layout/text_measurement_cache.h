@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef LAYOUT_TEXT_MEASUREMENT_CACHE_H_
+#define LAYOUT_TEXT_MEASUREMENT_CACHE_H_
+
+#include "type/type.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace layout {
+
+// Remembers what fonts have measured, so that neither breaking a paragraph
+// into lines nor laying out the same text again has to ask the font about
+// anything it has already measured.
+class TextMeasurementCache {
+public:
+    TextMeasurementCache() = default;
+    // Looks in `shared` before measuring anything, but never changes it, so
+    // that several caches can share one while it isn't changed elsewhere.
+    explicit TextMeasurementCache(TextMeasurementCache const *shared) : shared_{shared} {}
+
+    type::Size measure(std::shared_ptr<type::IFont const> const &, std::string_view, type::Px, type::Weight);
+
+    // See type::IFont::word_ends.
+    std::vector<int> const &word_ends(
+            std::shared_ptr<type::IFont const> const &, std::string_view text, type::Px, type::Weight);
+
+    [[nodiscard]] std::size_t size() const { return measurements_.size() + word_ends_.size(); }
+    void clear();
+    // Moves the measurements in `other` that aren't already in this over to it.
+    void merge(TextMeasurementCache &&other);
+
+private:
+    struct Key {
+        type::IFont const *font{};
+        int font_size{};
+        type::Weight weight{};
+        std::string text;
+    };
+
+    struct KeyView {
+        type::IFont const *font{};
+        int font_size{};
+        type::Weight weight{};
+        std::string_view text;
+    };
+
+    struct KeyLess {
+        using is_transparent = void;
+        template<typename A, typename B>
+        bool operator()(A const &a, B const &b) const {
+            return std::tuple{a.font, a.font_size, a.weight, std::string_view{a.text}}
+                    < std::tuple{b.font, b.font_size, b.weight, std::string_view{b.text}};
+        }
+    };
+
+    // The keys only hold on to the font's address, so the fonts are kept
+    // alive to make sure that a new font never ends up w/ an old one's entries.
+    std::set<std::shared_ptr<type::IFont const>> fonts_;
+    std::map<Key, type::Size, KeyLess> measurements_;
+    std::map<Key, std::vector<int>, KeyLess> word_ends_;
+    TextMeasurementCache const *shared_{};
+};
+
+} // namespace layout
+
+#endif
@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "layout/text_measurement_cache.h"
+
+#include "etest/etest2.h"
+#include "type/naive.h"
+#include "type/type.h"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+class CountingFont : public type::IFont {
+public:
+    type::Size measure(std::string_view text, type::Px font_size, type::Weight weight) const override {
+        ++measurements;
+        return type::NaiveFont{}.measure(text, font_size, weight);
+    }
+
+    mutable int measurements{};
+};
+
+} // namespace
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("measure", [](etest::IActions &a) {
+        auto font = std::make_shared<CountingFont>();
+        layout::TextMeasurementCache cache;
+
+        a.expect_eq(cache.measure(font, "hello", type::Px{10}, type::Weight::Normal), type::Size{25, 10});
+        a.expect_eq(cache.measure(font, "hello", type::Px{10}, type::Weight::Normal), type::Size{25, 10});
+        a.expect_eq(font->measurements, 1);
+
+        // Every part of the key matters.
+        std::ignore = cache.measure(font, "hello", type::Px{12}, type::Weight::Normal);
+        std::ignore = cache.measure(font, "hello", type::Px{10}, type::Weight::Bold);
+        std::ignore = cache.measure(font, "hell", type::Px{10}, type::Weight::Normal);
+        std::ignore = cache.measure(std::make_shared<CountingFont>(), "hello", type::Px{10}, type::Weight::Normal);
+        a.expect_eq(font->measurements, 4);
+        a.expect_eq(cache.size(), std::size_t{5});
+
+        cache.clear();
+        a.expect_eq(cache.size(), std::size_t{0});
+        std::ignore = cache.measure(font, "hello", type::Px{10}, type::Weight::Normal);
+        a.expect_eq(font->measurements, 5);
+    });
+
+    s.add_test("word_ends", [](etest::IActions &a) {
+        auto font = std::make_shared<CountingFont>();
+        layout::TextMeasurementCache cache;
+
+        auto const &ends = cache.word_ends(font, "a bb a ccc", type::Px{10}, type::Weight::Normal);
+        a.expect_eq(ends, (std::vector{5, 20, 30, 50}));
+        auto const measurements = font->measurements;
+
+        std::ignore = cache.word_ends(font, "a bb a ccc", type::Px{10}, type::Weight::Normal);
+        a.expect_eq(font->measurements, measurements);
+
+        a.expect_eq(cache.word_ends(font, "", type::Px{10}, type::Weight::Normal), std::vector{0});
+        a.expect_eq(cache.word_ends(font, "a  a", type::Px{10}, type::Weight::Normal), (std::vector{5, 10, 20}));
+    });
+
+    s.add_test("shared and merge", [](etest::IActions &a) {
+        auto font = std::make_shared<CountingFont>();
+        layout::TextMeasurementCache shared;
+        std::ignore = shared.measure(font, "hello", type::Px{10}, type::Weight::Normal);
+
+        layout::TextMeasurementCache cache{&shared};
+        std::ignore = cache.measure(font, "hello", type::Px{10}, type::Weight::Normal);
+        a.expect_eq(font->measurements, 1);
+        a.expect_eq(cache.size(), std::size_t{0});
+
+        std::ignore = cache.word_ends(font, "a b", type::Px{10}, type::Weight::Normal);
+        auto const measurements = font->measurements;
+        a.expect_eq(cache.size(), std::size_t{1});
+        a.expect_eq(shared.size(), std::size_t{1});
+
+        shared.merge(std::move(cache));
+        a.expect_eq(shared.size(), std::size_t{2});
+        std::ignore = shared.word_ends(font, "a b", type::Px{10}, type::Weight::Normal);
+        a.expect_eq(font->measurements, measurements);
+    });
+
+    return s.run();
+}
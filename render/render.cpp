@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -12,6 +12,7 @@
 #include "gfx/color.h"
 #include "gfx/font.h"
 #include "gfx/icanvas.h"
+#include "layout/box_index.h"
 #include "layout/layout_box.h"
 #include "style/styled_node.h"
 
@@ -77,12 +78,13 @@ void render_text(gfx::ICanvas &painter, layout::LayoutBox const &layout, std::st
             layout.get_property<css::PropertyId::FontWeight>(),
             layout.get_property<css::PropertyId::TextDecorationLine>());
     auto color = layout.get_property<css::PropertyId::Color>();
-    painter.draw_text(layout.dimensions.content.position(), text, fonts, font_size, style, color);
+    painter.draw_text(geom::snapped(layout.dimensions.content.position()), text, fonts, font_size, style, color);
 }
 
 void render_element(gfx::ICanvas &painter, layout::LayoutBox const &layout) {
     auto background_color = layout.get_property<css::PropertyId::BackgroundColor>();
-    auto const &border_size = layout.dimensions.border;
+    // Layout keeps borders to whole pixels, so this doesn't change their size.
+    auto const border_size = geom::snapped(layout.dimensions.border);
 
     gfx::Corners corners{};
     auto top_left = layout.get_property<css::PropertyId::BorderTopLeftRadius>();
@@ -105,9 +107,9 @@ void render_element(gfx::ICanvas &painter, layout::LayoutBox const &layout) {
         borders.bottom.color = layout.get_property<css::PropertyId::BorderBottomColor>();
         borders.bottom.size = border_size.bottom;
 
-        painter.draw_rect(layout.dimensions.padding_box(), background_color, borders, corners);
+        painter.draw_rect(geom::snapped(layout.dimensions.padding_box()), background_color, borders, corners);
     } else if (!is_fully_transparent(background_color)) {
-        painter.draw_rect(layout.dimensions.padding_box(), background_color, gfx::Borders{}, corners);
+        painter.draw_rect(geom::snapped(layout.dimensions.padding_box()), background_color, gfx::Borders{}, corners);
     }
 }
 
@@ -115,7 +117,7 @@ void render_image(gfx::ICanvas &painter, layout::LayoutBox const &layout, ImageV
     // TODO(robinlinden): Handle image scaling. image.{width,height} are unused
     // right now, but should be used to scale the image to work with the content
     // size.
-    painter.draw_pixels(layout.dimensions.content, image.rgba_data);
+    painter.draw_pixels(geom::snapped(layout.dimensions.content), image.rgba_data);
 }
 
 std::optional<std::string_view> get_image_id(layout::LayoutBox const &layout) {
@@ -154,7 +156,7 @@ void render_layout_impl(gfx::ICanvas &painter,
         layout::LayoutBox const &layout,
         std::optional<geom::Rect> const &clip,
         ImageLookupFn const &image_lookup) {
-    if (clip && clip->intersected(layout.dimensions.border_box()).empty()) {
+    if (clip && static_cast<geom::LayoutRect>(*clip).intersected(layout.dimensions.border_box()).empty()) {
         return;
     }
 
@@ -167,12 +169,9 @@ void render_layout_impl(gfx::ICanvas &painter,
     }
 }
 
-} // namespace
-
-void render_layout(gfx::ICanvas &painter,
-        layout::LayoutBox const &layout,
-        std::optional<geom::Rect> const &clip,
-        ImageLookupFn const &image_lookup) {
+// https://www.w3.org/TR/css-backgrounds-3/#special-backgrounds
+// If html or body has a background set, use that as the canvas background.
+void clear_canvas(gfx::ICanvas &painter, layout::LayoutBox const &layout) {
     static constexpr auto kGetBg = [](std::string_view xpath, layout::LayoutBox const &l) -> std::optional<gfx::Color> {
         auto d = dom::nodes_by_xpath(l, xpath);
         if (d.empty()) {
@@ -182,8 +181,6 @@ void render_layout(gfx::ICanvas &painter,
         return d[0]->get_property<css::PropertyId::BackgroundColor>();
     };
 
-    // https://www.w3.org/TR/css-backgrounds-3/#special-backgrounds
-    // If html or body has a background set, use that as the canvas background.
     if (auto html_bg = kGetBg("/html", layout); html_bg && html_bg != gfx::Color::from_css_name("transparent")) {
         painter.clear(*html_bg);
     } else if (auto body_bg = kGetBg("/html/body", layout);
@@ -192,16 +189,37 @@ void render_layout(gfx::ICanvas &painter,
     } else {
         painter.clear(gfx::Color{255, 255, 255});
     }
+}
 
+} // namespace
+
+void render_layout(gfx::ICanvas &painter,
+        layout::LayoutBox const &layout,
+        std::optional<geom::Rect> const &clip,
+        ImageLookupFn const &image_lookup) {
+    clear_canvas(painter, layout);
     render_layout_impl(painter, layout, clip, image_lookup);
 }
 
+void render_layout(gfx::ICanvas &painter,
+        layout::LayoutBox const &layout,
+        layout::BoxIndex const &index,
+        geom::Rect const &clip,
+        ImageLookupFn const &image_lookup) {
+    clear_canvas(painter, layout);
+    for (auto const *box : index.boxes_in(clip)) {
+        if (should_render(*box)) {
+            do_render(painter, *box, image_lookup);
+        }
+    }
+}
+
 namespace debug {
 namespace {
 
 // NOLINTNEXTLINE(misc-no-recursion)
 void render_layout_depth_impl(gfx::ICanvas &painter, layout::LayoutBox const &layout) {
-    painter.draw_rect(layout.dimensions.padding_box(), {0xFF, 0xFF, 0xFF, 0x30}, {}, {});
+    painter.draw_rect(geom::snapped(layout.dimensions.padding_box()), {0xFF, 0xFF, 0xFF, 0x30}, {}, {});
     for (auto const &child : layout.children) {
         render_layout_depth_impl(painter, child);
     }
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -7,6 +7,7 @@
 
 #include "geom/geom.h"
 #include "gfx/icanvas.h"
+#include "layout/box_index.h"
 #include "layout/layout_box.h"
 
 #include <cstdint>
@@ -31,6 +32,15 @@ void render_layout(
         std::optional<geom::Rect> const &clip = std::nullopt,
         ImageLookupFn const & = [](auto) { return std::nullopt; });
 
+// Draws the same thing as the above, but only looks at the boxes the index
+// finds in the clip rect.
+void render_layout(
+        gfx::ICanvas &,
+        layout::LayoutBox const &,
+        layout::BoxIndex const &,
+        geom::Rect const &clip,
+        ImageLookupFn const & = [](auto) { return std::nullopt; });
+
 namespace debug {
 void render_layout_depth(gfx::ICanvas &, layout::LayoutBox const &);
 } // namespace debug
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2022-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2022-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -11,6 +11,7 @@
 #include "gfx/canvas_command_saver.h"
 #include "gfx/color.h"
 #include "gfx/icanvas.h"
+#include "layout/box_index.h"
 #include "layout/layout_box.h"
 #include "style/styled_node.h"
 
@@ -492,6 +493,37 @@ int main() {
         a.expect_eq(saver.take_commands(), CanvasCommands{gfx::ClearCmd{{0xFF, 0xFF, 0xFF}}});
     });
 
+    s.add_test("culling w/ an index", [](etest::IActions &a) {
+        dom::Node dom = dom::Element{"dummy"};
+        auto styled = style::StyledNode{
+                .node = dom,
+                .properties = {{css::PropertyId::Display, "block"}, {css::PropertyId::BackgroundColor, "#010203"}},
+        };
+
+        auto layout = layout::LayoutBox{
+                .node = &styled,
+                .dimensions = {{0, 0, 20, 40}},
+                .children{
+                        {&styled, {{0, 0, 20, 10}}},
+                        {&styled, {{0, 10, 20, 10}}, {{&styled, {{5, 12, 5, 5}}}}},
+                        {&styled, {{0, 20, 20, 20}}},
+                },
+        };
+        layout::BoxIndex const index{layout};
+
+        gfx::CanvasCommandSaver saver;
+        for (auto clip : {geom::Rect{0, 0, 20, 40},
+                     geom::Rect{0, 5, 20, 10},
+                     geom::Rect{0, 13, 6, 1},
+                     geom::Rect{0, 40, 20, 10},
+                     geom::Rect{-5, -5, 5, 5}}) {
+            render::render_layout(saver, layout, clip);
+            auto expected = saver.take_commands();
+            render::render_layout(saver, layout, index, clip);
+            a.expect_eq(saver.take_commands(), expected);
+        }
+    });
+
     s.add_test("culling w/ element border", [](etest::IActions &a) {
         dom::Node dom = dom::Element{"dummy"};
         auto styled = style::StyledNode{
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/ancestor_filter.h"
+
+#include "dom/dom.h"
+
+#include <cstdint>
+#include <ranges>
+#include <string_view>
+
+namespace style {
+
+template<typename OnHashT>
+void AncestorFilter::for_each_hash(dom::Element const &element, OnHashT &&on_hash) {
+    on_hash(hash(Kind::Type, element.name));
+
+    if (auto id = element.attributes.find("id"); id != element.attributes.end()) {
+        on_hash(hash(Kind::Id, id->second));
+    }
+
+    if (auto classes = element.attributes.find("class"); classes != element.attributes.end()) {
+        for (auto cls : classes->second | std::views::split(' ')) {
+            if (!cls.empty()) {
+                on_hash(hash(Kind::Class, std::string_view{cls}));
+            }
+        }
+    }
+}
+
+void AncestorFilter::push(dom::Element const &element) {
+    for_each_hash(element, [this](std::uint32_t h) { add(h); });
+}
+
+void AncestorFilter::pop(dom::Element const &element) {
+    for_each_hash(element, [this](std::uint32_t h) { remove(h); });
+}
+
+void AncestorFilter::add(std::uint32_t hash) {
+    for (auto index : {hash & kMask, (hash >> kBits) & kMask}) {
+        if (counters_[index] != kSaturated) {
+            ++counters_[index];
+        }
+    }
+}
+
+void AncestorFilter::remove(std::uint32_t hash) {
+    for (auto index : {hash & kMask, (hash >> kBits) & kMask}) {
+        if (counters_[index] != kSaturated) {
+            --counters_[index];
+        }
+    }
+}
+
+} // namespace style
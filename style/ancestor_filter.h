@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef STYLE_ANCESTOR_FILTER_H_
+#define STYLE_ANCESTOR_FILTER_H_
+
+#include "dom/dom.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace style {
+
+// A counting Bloom filter of the types, ids, and classes of the ancestors of
+// the element currently being styled. If a selector requires an ancestor w/
+// something not in the filter, it can't match, and we don't have to walk up
+// the tree to find that out.
+class AncestorFilter {
+public:
+    enum class Kind : std::uint8_t {
+        Type,
+        Id,
+        Class,
+    };
+
+    // Never returns 0.
+    static constexpr std::uint32_t hash(Kind kind, std::string_view value) {
+        // FNV-1a, w/ the kind mixed in so that e.g. the class "div" and the
+        // type "div" don't collide.
+        std::uint32_t h = 2166136261u ^ static_cast<std::uint32_t>(kind);
+        for (char c : value) {
+            h ^= static_cast<std::uint8_t>(c);
+            h *= 16777619u;
+        }
+
+        return h == 0 ? 1 : h;
+    }
+
+    void push(dom::Element const &);
+    void pop(dom::Element const &);
+
+    // False positives are possible, but false negatives aren't.
+    [[nodiscard]] bool might_contain(std::uint32_t hash) const {
+        return counters_[hash & kMask] != 0 && counters_[(hash >> kBits) & kMask] != 0;
+    }
+
+    [[nodiscard]] bool might_contain_all(std::span<std::uint32_t const> hashes) const {
+        for (auto hash : hashes) {
+            if (!might_contain(hash)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr std::size_t kBits = 12;
+    static constexpr std::uint32_t kMask = (1u << kBits) - 1;
+    // Saturated counters are stuck there, since we don't know how many
+    // elements were added after they saturated.
+    static constexpr std::uint8_t kSaturated = 0xff;
+
+    std::array<std::uint8_t, std::size_t{1} << kBits> counters_{};
+
+    template<typename OnHashT>
+    static void for_each_hash(dom::Element const &, OnHashT &&);
+
+    void add(std::uint32_t hash);
+    void remove(std::uint32_t hash);
+};
+
+} // namespace style
+
+#endif
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/ancestor_filter.h"
+
+#include "dom/dom.h"
+#include "etest/etest2.h"
+
+#include <array>
+#include <cstdint>
+
+int main() {
+    etest::Suite s;
+    using Kind = style::AncestorFilter::Kind;
+
+    s.add_test("push and pop", [](etest::IActions &a) {
+        style::AncestorFilter filter;
+        auto const div = style::AncestorFilter::hash(Kind::Type, "div");
+        auto const main = style::AncestorFilter::hash(Kind::Id, "main");
+        auto const cls = style::AncestorFilter::hash(Kind::Class, "b");
+        a.expect(!filter.might_contain(div));
+
+        dom::Element outer{"div", {{"id", "main"}, {"class", "a  b"}}};
+        dom::Element inner{"div"};
+        filter.push(outer);
+        filter.push(inner);
+        a.expect(filter.might_contain_all(std::array{div, main, cls}));
+
+        filter.pop(inner);
+        a.expect(filter.might_contain_all(std::array{div, main, cls}));
+
+        filter.pop(outer);
+        a.expect(!filter.might_contain(div));
+        a.expect(!filter.might_contain(main));
+        a.expect(!filter.might_contain(cls));
+    });
+
+    s.add_test("kinds don't collide", [](etest::IActions &a) {
+        style::AncestorFilter filter;
+        filter.push(dom::Element{"div"});
+        a.expect(filter.might_contain(style::AncestorFilter::hash(Kind::Type, "div")));
+        a.expect(!filter.might_contain(style::AncestorFilter::hash(Kind::Class, "div")));
+        a.expect(!filter.might_contain(style::AncestorFilter::hash(Kind::Id, "div")));
+    });
+
+    s.add_test("saturation", [](etest::IActions &a) {
+        style::AncestorFilter filter;
+        dom::Element div{"div"};
+        for (int i = 0; i < 300; ++i) {
+            filter.push(div);
+        }
+
+        for (int i = 0; i < 300; ++i) {
+            filter.pop(div);
+        }
+
+        // Saturated counters stick, so this is a false positive, but not a crash.
+        a.expect(filter.might_contain(style::AncestorFilter::hash(Kind::Type, "div")));
+    });
+
+    return s.run();
+}
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/computed_style.h"
+
+#include "css/property_id.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace style {
+namespace {
+
+template<typename GroupT, typename SetT>
+std::shared_ptr<GroupT const> intern_impl(SetT &set, GroupT &&group) {
+    if (auto it = set.find(group); it != set.end()) {
+        return *it;
+    }
+
+    return *set.insert(std::make_shared<GroupT const>(std::move(group))).first;
+}
+
+} // namespace
+
+std::shared_ptr<ComputedStyle::InheritedGroup const> ComputedStyle::Cache::intern(InheritedGroup &&group) {
+    return intern_impl(inherited_, std::move(group));
+}
+
+std::shared_ptr<ComputedStyle::NonInheritedGroup const> ComputedStyle::Cache::intern(NonInheritedGroup &&group) {
+    return intern_impl(non_inherited_, std::move(group));
+}
+
+std::shared_ptr<ComputedStyle::CustomProperties const> ComputedStyle::Cache::intern(CustomProperties &&custom) {
+    return intern_impl(custom_, std::move(custom));
+}
+
+void ComputedStyle::Builder::set(css::PropertyId id, std::string_view value) {
+    auto const i = static_cast<std::size_t>(id);
+    if (kIsInherited[i]) {
+        if (!inherited_) {
+            if (style_.get(id) == value) {
+                return;
+            }
+
+            inherited_ = std::make_unique<InheritedGroup>(*style_.inherited_);
+        }
+
+        inherited_->values[kGroupIndex[i]] = value;
+    } else {
+        if (!non_inherited_) {
+            if (style_.get(id) == value) {
+                return;
+            }
+
+            non_inherited_ = std::make_unique<NonInheritedGroup>(*style_.non_inherited_);
+        }
+
+        non_inherited_->values[kGroupIndex[i]] = value;
+    }
+}
+
+void ComputedStyle::Builder::set_custom_properties(CustomProperties custom) {
+    custom_ = std::make_unique<CustomProperties>(std::move(custom));
+}
+
+ComputedStyle ComputedStyle::Builder::build(Cache *cache) && {
+    if (inherited_) {
+        style_.inherited_ = cache != nullptr ? cache->intern(std::move(*inherited_))
+                                             : std::make_shared<InheritedGroup const>(std::move(*inherited_));
+    }
+
+    if (non_inherited_) {
+        style_.non_inherited_ = cache != nullptr
+                ? cache->intern(std::move(*non_inherited_))
+                : std::make_shared<NonInheritedGroup const>(std::move(*non_inherited_));
+    }
+
+    if (custom_) {
+        style_.custom_ = cache != nullptr ? cache->intern(std::move(*custom_))
+                                          : std::make_shared<CustomProperties const>(std::move(*custom_));
+    }
+
+    return std::move(style_);
+}
+
+ComputedStyle ComputedStyle::initial() {
+    static auto const kInitial = [] {
+        InheritedGroup inherited;
+        NonInheritedGroup non_inherited;
+        for (std::size_t i = 0; i < css::kPropertyIdCount; ++i) {
+            auto value = css::initial_value(static_cast<css::PropertyId>(i));
+            if (kIsInherited[i]) {
+                inherited.values[kGroupIndex[i]] = value;
+            } else {
+                non_inherited.values[kGroupIndex[i]] = value;
+            }
+        }
+
+        ComputedStyle style;
+        style.inherited_ = std::make_shared<InheritedGroup const>(std::move(inherited));
+        style.non_inherited_ = std::make_shared<NonInheritedGroup const>(std::move(non_inherited));
+        return style;
+    }();
+
+    return kInitial;
+}
+
+ComputedStyle ComputedStyle::inheriting_from(ComputedStyle const &parent) {
+    auto style = initial();
+    style.inherited_ = parent.inherited_;
+    style.custom_ = parent.custom_;
+    return style;
+}
+
+} // namespace style
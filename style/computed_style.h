@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef STYLE_COMPUTED_STYLE_H_
+#define STYLE_COMPUTED_STYLE_H_
+
+#include "css/property_id.h"
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace style {
+
+// The resolved value of every property of a node, split into the inherited and
+// the non-inherited properties. The groups are immutable and shared: a node
+// that doesn't declare any inherited properties points to its parent's
+// inherited group, and one w/o any non-inherited declarations points to a
+// group of initial values. Changing anything copies the affected group.
+//
+// Custom properties are inherited as well, and are kept in a third group w/
+// any var() references between them already resolved.
+class ComputedStyle {
+    static constexpr auto kIsInherited = [] {
+        std::array<bool, css::kPropertyIdCount> inherited{};
+        for (std::size_t i = 0; i < inherited.size(); ++i) {
+            inherited[i] = css::is_inherited(static_cast<css::PropertyId>(i));
+        }
+        return inherited;
+    }();
+
+    static constexpr std::size_t kInheritedCount = [] {
+        std::size_t count = 0;
+        for (bool inherited : kIsInherited) {
+            count += inherited ? 1 : 0;
+        }
+        return count;
+    }();
+
+    // Index into the group the property belongs to.
+    static constexpr auto kGroupIndex = [] {
+        std::array<std::uint8_t, css::kPropertyIdCount> index{};
+        std::uint8_t inherited = 0;
+        std::uint8_t non_inherited = 0;
+        for (std::size_t i = 0; i < index.size(); ++i) {
+            index[i] = kIsInherited[i] ? inherited++ : non_inherited++;
+        }
+        return index;
+    }();
+
+public:
+    template<std::size_t SizeT>
+    struct Group {
+        std::array<std::string, SizeT> values;
+        [[nodiscard]] auto operator<=>(Group const &) const = default;
+    };
+
+    using InheritedGroup = Group<kInheritedCount>;
+    using NonInheritedGroup = Group<css::kPropertyIdCount - kInheritedCount>;
+    using CustomProperties = std::map<std::string, std::string, std::less<>>;
+
+    // Deduplicates groups so that nodes ending up w/ the same values share
+    // them even if they had to make changes to what they inherited.
+    class Cache {
+    public:
+        std::shared_ptr<InheritedGroup const> intern(InheritedGroup &&);
+        std::shared_ptr<NonInheritedGroup const> intern(NonInheritedGroup &&);
+        std::shared_ptr<CustomProperties const> intern(CustomProperties &&);
+
+        [[nodiscard]] std::size_t size() const {
+            return inherited_.size() + non_inherited_.size() + custom_.size();
+        }
+
+    private:
+        struct DerefLess {
+            using is_transparent = void;
+            template<typename T>
+            bool operator()(std::shared_ptr<T const> const &a, std::shared_ptr<T const> const &b) const {
+                return *a < *b;
+            }
+            template<typename T>
+            bool operator()(std::shared_ptr<T const> const &a, T const &b) const {
+                return *a < b;
+            }
+            template<typename T>
+            bool operator()(T const &a, std::shared_ptr<T const> const &b) const {
+                return a < *b;
+            }
+        };
+
+        std::set<std::shared_ptr<InheritedGroup const>, DerefLess> inherited_;
+        std::set<std::shared_ptr<NonInheritedGroup const>, DerefLess> non_inherited_;
+        std::set<std::shared_ptr<CustomProperties const>, DerefLess> custom_;
+    };
+
+    class Builder;
+
+    // Everything set to its initial value.
+    static ComputedStyle initial();
+
+    // The inherited properties from `parent`, the rest set to their initial values.
+    static ComputedStyle inheriting_from(ComputedStyle const &parent);
+
+    // True for default-constructed styles.
+    [[nodiscard]] bool empty() const { return inherited_ == nullptr; }
+
+    [[nodiscard]] std::string_view get(css::PropertyId id) const {
+        auto const i = static_cast<std::size_t>(id);
+        return kIsInherited[i] ? inherited_->values[kGroupIndex[i]] : non_inherited_->values[kGroupIndex[i]];
+    }
+
+    [[nodiscard]] CustomProperties const &custom_properties() const {
+        static CustomProperties const kNone;
+        return custom_ != nullptr ? *custom_ : kNone;
+    }
+
+    [[nodiscard]] std::optional<std::string_view> get_custom(std::string_view name) const {
+        auto const &custom = custom_properties();
+        auto it = custom.find(name);
+        return it != custom.end() ? std::optional<std::string_view>{it->second} : std::nullopt;
+    }
+
+    // The font sizes in px, as these are needed to resolve every font-relative length.
+    [[nodiscard]] int font_size() const { return font_size_; }
+    [[nodiscard]] int root_font_size() const { return root_font_size_; }
+
+    [[nodiscard]] bool operator==(ComputedStyle const &other) const {
+        auto equal = [](auto const &a, auto const &b) { return a == b || (a && b && *a == *b); };
+        return equal(inherited_, other.inherited_) && equal(non_inherited_, other.non_inherited_)
+                && custom_properties() == other.custom_properties() && font_size_ == other.font_size_
+                && root_font_size_ == other.root_font_size_;
+    }
+
+    // Whether the two styles share their groups, i.e. no memory is spent on the second one.
+    [[nodiscard]] bool shares_groups_with(ComputedStyle const &other) const {
+        return inherited_ == other.inherited_ && non_inherited_ == other.non_inherited_ && custom_ == other.custom_;
+    }
+
+private:
+    std::shared_ptr<InheritedGroup const> inherited_;
+    std::shared_ptr<NonInheritedGroup const> non_inherited_;
+    std::shared_ptr<CustomProperties const> custom_;
+    int font_size_{};
+    int root_font_size_{};
+};
+
+// Builds a style starting from `base`, copying a group the first time
+// something in it is changed.
+class ComputedStyle::Builder {
+public:
+    explicit Builder(ComputedStyle base) : style_{std::move(base)} {}
+
+    void set(css::PropertyId, std::string_view value);
+    void set_custom_properties(CustomProperties);
+    void set_font_sizes(int font_size, int root_font_size) {
+        style_.font_size_ = font_size;
+        style_.root_font_size_ = root_font_size;
+    }
+    [[nodiscard]] ComputedStyle build(Cache * = nullptr) &&;
+
+private:
+    ComputedStyle style_;
+    std::unique_ptr<InheritedGroup> inherited_;
+    std::unique_ptr<NonInheritedGroup> non_inherited_;
+    std::unique_ptr<CustomProperties> custom_;
+};
+
+} // namespace style
+
+#endif
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/computed_style.h"
+
+#include "css/property_id.h"
+#include "etest/etest2.h"
+
+#include <cstddef>
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("initial", [](etest::IActions &a) {
+        auto initial = style::ComputedStyle::initial();
+        a.expect(!initial.empty());
+        a.expect(style::ComputedStyle{}.empty());
+        a.expect_eq(initial.get(css::PropertyId::Color), css::initial_value(css::PropertyId::Color));
+        a.expect_eq(initial.get(css::PropertyId::Width), css::initial_value(css::PropertyId::Width));
+        a.expect(initial.shares_groups_with(style::ComputedStyle::initial()));
+    });
+
+    s.add_test("copy on write", [](etest::IActions &a) {
+        auto const initial = style::ComputedStyle::initial();
+
+        style::ComputedStyle::Builder builder{initial};
+        builder.set(css::PropertyId::Color, "red");
+        auto red = std::move(builder).build();
+        a.expect_eq(red.get(css::PropertyId::Color), "red");
+        a.expect_eq(initial.get(css::PropertyId::Color), css::initial_value(css::PropertyId::Color));
+        a.expect(!red.shares_groups_with(initial));
+
+        // Only the inherited group was copied.
+        auto child = style::ComputedStyle::inheriting_from(red);
+        a.expect_eq(child.get(css::PropertyId::Color), "red");
+        a.expect(child.shares_groups_with(red));
+
+        style::ComputedStyle::Builder width_builder{child};
+        width_builder.set(css::PropertyId::Width, "5px");
+        auto with_width = std::move(width_builder).build();
+        a.expect_eq(with_width.get(css::PropertyId::Width), "5px");
+        a.expect_eq(with_width.get(css::PropertyId::Color), "red");
+        a.expect(style::ComputedStyle::inheriting_from(with_width).shares_groups_with(child));
+    });
+
+    s.add_test("setting things more than once", [](etest::IActions &a) {
+        style::ComputedStyle::Builder builder{style::ComputedStyle::initial()};
+        builder.set(css::PropertyId::Color, "red");
+        builder.set(css::PropertyId::Color, css::initial_value(css::PropertyId::Color));
+        builder.set(css::PropertyId::Width, "1px");
+        builder.set(css::PropertyId::Width, "2px");
+        auto style = std::move(builder).build();
+        a.expect_eq(style.get(css::PropertyId::Color), css::initial_value(css::PropertyId::Color));
+        a.expect_eq(style.get(css::PropertyId::Width), "2px");
+    });
+
+    s.add_test("cache", [](etest::IActions &a) {
+        style::ComputedStyle::Cache cache;
+        auto build = [&](auto value) {
+            style::ComputedStyle::Builder builder{style::ComputedStyle::initial()};
+            builder.set(css::PropertyId::Width, value);
+            builder.set(css::PropertyId::Color, value);
+            return std::move(builder).build(&cache);
+        };
+
+        auto first = build("1px");
+        auto second = build("1px");
+        auto third = build("2px");
+        a.expect(first.shares_groups_with(second));
+        a.expect(!first.shares_groups_with(third));
+        a.expect_eq(cache.size(), std::size_t{4});
+    });
+
+    return s.run();
+}
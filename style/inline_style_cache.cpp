@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/inline_style_cache.h"
+
+#include "css/parser.h"
+#include "css/rule.h"
+
+#include <spdlog/spdlog.h>
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace style {
+
+css::Rule const *InlineStyleCache::get(std::string_view style_attribute) {
+    std::scoped_lock lock{mtx_};
+    auto it = cache_.find(style_attribute);
+    if (it == cache_.end()) {
+        auto rule = css::parse_declarations(style_attribute);
+        if (!rule) {
+            spdlog::warn("Failed to parse inline style '{}'", style_attribute);
+        }
+
+        it = cache_.emplace(std::string{style_attribute}, std::move(rule)).first;
+    }
+
+    return it->second.has_value() ? &*it->second : nullptr;
+}
+
+} // namespace style
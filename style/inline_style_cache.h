@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef STYLE_INLINE_STYLE_CACHE_H_
+#define STYLE_INLINE_STYLE_CACHE_H_
+
+#include "css/rule.h"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace style {
+
+// Parsed style attributes, keyed by the attribute value. Generated HTML tends
+// to repeat the same handful of inline styles on a lot of elements, and
+// keeping this around between restyles means they're only parsed once. This
+// is safe to use from several threads at once.
+class InlineStyleCache {
+public:
+    // Returns nullptr if the style attribute couldn't be parsed.
+    css::Rule const *get(std::string_view style_attribute);
+
+    [[nodiscard]] std::size_t size() const {
+        std::scoped_lock lock{mtx_};
+        return cache_.size();
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::map<std::string, std::optional<css::Rule>, std::less<>> cache_;
+};
+
+} // namespace style
+
+#endif
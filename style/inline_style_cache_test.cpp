@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/inline_style_cache.h"
+
+#include "css/property_id.h"
+#include "css/rule.h"
+#include "etest/etest2.h"
+
+#include <cstddef>
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("parsed styles are shared", [](etest::IActions &a) {
+        style::InlineStyleCache cache;
+        auto const *first = cache.get("color: red");
+        a.require(first != nullptr);
+        a.expect_eq(*first, css::Rule{.declarations{{css::PropertyId::Color, "red"}}});
+        a.expect_eq(cache.get("color: red"), first);
+        a.expect_eq(cache.size(), std::size_t{1});
+
+        a.expect(cache.get("color: blue") != first);
+        a.expect_eq(cache.size(), std::size_t{2});
+    });
+
+    s.add_test("parse errors are cached", [](etest::IActions &a) {
+        style::InlineStyleCache cache;
+        a.expect_eq(cache.get("color"), nullptr);
+        a.expect_eq(cache.get("color"), nullptr);
+        a.expect_eq(cache.size(), std::size_t{1});
+    });
+
+    return s.run();
+}
@@ -0,0 +1,279 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/rule_set.h"
+
+#include "style/ancestor_filter.h"
+#include "style/selector.h"
+#include "style/styled_node.h"
+
+#include "css/media_query.h"
+#include "css/rule.h"
+#include "css/style_sheet.h"
+#include "dom/dom.h"
+#include "dom/mutation_log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace style {
+
+namespace {
+CompiledRule compile(css::Rule const &rule) {
+    CompiledRule compiled{.rule = &rule};
+    compiled.selectors.reserve(rule.selectors.size());
+    for (auto const &selector : rule.selectors) {
+        if (auto s = Selector::parse(selector)) {
+            compiled.selectors.push_back(*std::move(s));
+        }
+    }
+
+    return compiled;
+}
+
+bool contains_class(std::string_view classes, std::string_view needle_class) {
+    return std::ranges::any_of(
+            classes | std::views::split(' '), [&](auto cls) { return std::string_view{cls} == needle_class; });
+}
+} // namespace
+
+RuleSet::RuleSet(css::StyleSheet const &stylesheet, std::size_t user_agent_rules) {
+    rules_.reserve(stylesheet.rules.size());
+    for (auto const &rule : stylesheet.rules) {
+        if (!rule.media_query.has_value()) {
+            rules_.push_back({.rule = compile(rule)});
+            continue;
+        }
+
+        auto const &query = *rule.media_query;
+
+        // All rules in a @media block get the same query, so check the
+        // previous one before looking through all of them.
+        if (!media_queries_.empty() && *media_queries_.back() == query) {
+            rules_.push_back({.rule = compile(rule), .media_query = media_queries_.size() - 1});
+            continue;
+        }
+
+        auto it = std::ranges::find_if(media_queries_, [&](auto const *q) { return *q == query; });
+        if (it == media_queries_.end()) {
+            media_queries_.push_back(&query);
+            it = std::prev(media_queries_.end());
+        }
+
+        rules_.push_back(
+                {.rule = compile(rule), .media_query = static_cast<std::size_t>(it - media_queries_.begin())});
+    }
+
+    for (std::size_t i = 0; i < rules_.size(); ++i) {
+        std::uint64_t const origin = i < user_agent_rules ? 0 : 1;
+        for (std::size_t j = 0; j < rules_[i].rule.selectors.size(); ++j) {
+            auto const &selector = rules_[i].rule.selectors[j];
+            std::uint64_t const cascade_key = (origin << 62) | (std::uint64_t{selector.specificity} << 32) | i;
+            add_to_bucket({.cascade_key = cascade_key, .rule = i, .selector = j});
+            add_invalidations(selector, true);
+        }
+    }
+
+    auto sort_bucket = [](Bucket &bucket) { std::ranges::sort(bucket, std::greater{}); };
+    std::ranges::for_each(id_buckets_ | std::views::values, sort_bucket);
+    std::ranges::for_each(class_buckets_ | std::views::values, sort_bucket);
+    std::ranges::for_each(type_buckets_ | std::views::values, sort_bucket);
+    sort_bucket(universal_bucket_);
+}
+
+RuleSet::ActiveRules RuleSet::active_rules(css::MediaQuery::Context const &ctx) const {
+    std::vector<bool> query_results;
+    query_results.reserve(media_queries_.size());
+    for (auto const *query : media_queries_) {
+        query_results.push_back(query->evaluate(ctx));
+    }
+
+    ActiveRules active;
+    active.reserve(rules_.size());
+    for (auto const &[rule, media_query] : rules_) {
+        active.push_back(!media_query.has_value() || query_results[*media_query]);
+    }
+
+    return active;
+}
+
+std::vector<css::Rule const *> RuleSet::matching_rules(
+        StyledNode const &node, ActiveRules const &active, AncestorFilter const *ancestors) const {
+    auto const *element = std::get_if<dom::Element>(&node.node);
+    if (element == nullptr) {
+        return {};
+    }
+
+    std::vector<std::span<SelectorRef const>> buckets;
+    auto add_bucket = [&](Buckets const &candidates, std::string_view key) {
+        if (auto it = candidates.find(key); it != candidates.end()) {
+            buckets.emplace_back(it->second);
+        }
+    };
+
+    if (auto id = element->attributes.find("id"); id != element->attributes.end()) {
+        add_bucket(id_buckets_, id->second);
+    }
+
+    if (auto classes = element->attributes.find("class"); classes != element->attributes.end()) {
+        for (auto cls : classes->second | std::views::split(' ')) {
+            if (!cls.empty()) {
+                add_bucket(class_buckets_, std::string_view{cls});
+            }
+        }
+    }
+
+    add_bucket(type_buckets_, element->name);
+    if (!universal_bucket_.empty()) {
+        buckets.emplace_back(universal_bucket_);
+    }
+
+    // k-way merge of the buckets, highest cascade key first. Going from the
+    // highest means that a rule is placed according to its most specific
+    // matching selector, and its other selectors don't have to be checked.
+    auto lower_priority = [](auto const &a, auto const &b) { return a.front() < b.front(); };
+    std::ranges::make_heap(buckets, lower_priority);
+
+    std::vector<std::size_t> matched_rules;
+    // Only rules w/ more than one selector can come up again, so only those
+    // are looked up, and in a sorted copy. Most rules have just one selector.
+    std::vector<std::size_t> matched_rules_with_selector_lists;
+    std::optional<SelectorRef> previous;
+    while (!buckets.empty()) {
+        std::ranges::pop_heap(buckets, lower_priority);
+        auto const ref = buckets.back().front();
+        if (buckets.back().size() == 1) {
+            buckets.pop_back();
+        } else {
+            buckets.back() = buckets.back().subspan(1);
+            std::ranges::push_heap(buckets, lower_priority);
+        }
+
+        // An element w/ a repeated class gets the same bucket twice.
+        if (std::exchange(previous, ref) == ref) {
+            continue;
+        }
+
+        auto const &rule = rules_[ref.rule].rule;
+        auto const has_selector_list = rule.selectors.size() > 1;
+        if (!active[ref.rule]
+                || (has_selector_list && std::ranges::binary_search(matched_rules_with_selector_lists, ref.rule))) {
+            continue;
+        }
+
+        auto const &candidate = rule.selectors[ref.selector];
+        if (ancestors != nullptr && !ancestors->might_contain_all(candidate.ancestor_hashes)) {
+            continue;
+        }
+
+        if (is_match(node, candidate)) {
+            matched_rules.push_back(ref.rule);
+            if (has_selector_list) {
+                matched_rules_with_selector_lists.insert(
+                        std::ranges::upper_bound(matched_rules_with_selector_lists, ref.rule), ref.rule);
+            }
+        }
+    }
+
+    std::vector<css::Rule const *> matched;
+    matched.reserve(matched_rules.size());
+    for (auto rule : std::views::reverse(matched_rules)) {
+        matched.push_back(rules_[rule].rule.rule);
+    }
+
+    return matched;
+}
+
+Invalidation RuleSet::invalidation(dom::AttributeChange const &change) const {
+    Invalidation result{};
+    auto add = [&](Invalidations const &invalidations, std::string_view key) {
+        if (auto it = invalidations.find(key); it != invalidations.end()) {
+            result |= it->second;
+        }
+    };
+
+    add(attribute_invalidations_, change.name);
+
+    auto const &attributes = change.element->attributes;
+    auto it = attributes.find(change.name);
+    std::string_view const old_value = change.old_value.has_value() ? std::string_view{*change.old_value} : "";
+    std::string_view const new_value = it != attributes.end() ? std::string_view{it->second} : "";
+
+    if (change.name == "style") {
+        result.element = true;
+    } else if (change.name == "id") {
+        add(id_invalidations_, old_value);
+        add(id_invalidations_, new_value);
+    } else if (change.name == "class") {
+        // Only the classes that were added or removed matter.
+        auto add_classes_missing_from = [&](std::string_view classes, std::string_view other) {
+            for (auto cls : classes | std::views::split(' ')) {
+                if (!cls.empty() && !contains_class(other, std::string_view{cls})) {
+                    add(class_invalidations_, std::string_view{cls});
+                }
+            }
+        };
+
+        add_classes_missing_from(old_value, new_value);
+        add_classes_missing_from(new_value, old_value);
+    }
+
+    return result;
+}
+
+void RuleSet::add_to_bucket(SelectorRef ref) {
+    auto const &subject = rules_[ref.rule].rule.selectors[ref.selector].compounds.front();
+    if (subject.id.has_value()) {
+        id_buckets_[*subject.id].push_back(ref);
+    } else if (!subject.classes.empty()) {
+        class_buckets_[subject.classes.front()].push_back(ref);
+    } else if (!subject.type.empty()) {
+        type_buckets_[subject.type].push_back(ref);
+    } else {
+        universal_bucket_.push_back(ref);
+    }
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void RuleSet::add_invalidations(Selector const &selector, bool subject_is_element) {
+    for (std::size_t i = 0; i < selector.compounds.size(); ++i) {
+        auto const &compound = selector.compounds[i];
+        bool const is_element = i == 0 && subject_is_element;
+        Invalidation const invalidation{.element = is_element, .descendants = !is_element};
+
+        if (compound.id.has_value()) {
+            id_invalidations_[*compound.id] |= invalidation;
+        }
+
+        for (auto cls : compound.classes) {
+            class_invalidations_[cls] |= invalidation;
+        }
+
+        for (auto const &attribute : compound.attributes) {
+            attribute_invalidations_[attribute.name] |= invalidation;
+        }
+
+        if (std::ranges::contains(compound.pseudo_classes, PseudoClass::Link)) {
+            attribute_invalidations_["href"] |= invalidation;
+        }
+
+        for (auto const &alternatives : compound.is) {
+            for (auto const &alternative : alternatives) {
+                add_invalidations(alternative, is_element);
+            }
+        }
+    }
+}
+
+} // namespace style
@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef STYLE_RULE_SET_H_
+#define STYLE_RULE_SET_H_
+
+#include "style/ancestor_filter.h"
+#include "style/selector.h"
+#include "style/styled_node.h"
+
+#include "css/media_query.h"
+#include "css/rule.h"
+#include "css/style_sheet.h"
+#include "dom/mutation_log.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace style {
+
+// What has to be restyled when something about an element changes.
+struct Invalidation {
+    bool element{};
+    bool descendants{};
+
+    [[nodiscard]] constexpr bool operator==(Invalidation const &) const = default;
+    constexpr Invalidation &operator|=(Invalidation const &other) {
+        element = element || other.element;
+        descendants = descendants || other.descendants;
+        return *this;
+    }
+};
+
+struct CompiledRule {
+    css::Rule const *rule{};
+    // Selectors we don't support never match, so they're left out.
+    std::vector<Selector> selectors;
+};
+
+// A stylesheet prepared for being matched against a lot of nodes. This holds
+// pointers into the stylesheet, so the stylesheet must outlive the rule set.
+// Selectors are compiled up front so that matching doesn't need to parse them.
+class RuleSet {
+public:
+    // The first `user_agent_rules` rules are the browser's built-in ones,
+    // which lose to the page's rules no matter their specificity.
+    explicit RuleSet(css::StyleSheet const &, std::size_t user_agent_rules = 0);
+
+    // Whether each rule applies in the given media context, indexed like the
+    // rules in the stylesheet. Every distinct media query is only evaluated once.
+    using ActiveRules = std::vector<bool>;
+    [[nodiscard]] ActiveRules active_rules(css::MediaQuery::Context const &) const;
+
+    // The active rules w/ a selector matching the node, in cascade order, so
+    // that declarations in later rules win. The cascade order is origin, then
+    // the specificity of the most specific matching selector, then stylesheet
+    // order.
+    // If an AncestorFilter w/ the node's ancestors is passed in, it's used to
+    // skip selectors requiring ancestors the node doesn't have.
+    [[nodiscard]] std::vector<css::Rule const *> matching_rules(
+            StyledNode const &, ActiveRules const &, AncestorFilter const * = nullptr) const;
+
+    // Based on the ids, classes, and attributes the selectors look at, so a
+    // change no selector cares about doesn't invalidate anything. Selectors
+    // in inactive @media blocks are included so that this doesn't depend on
+    // the media context.
+    [[nodiscard]] Invalidation invalidation(dom::AttributeChange const &) const;
+
+    [[nodiscard]] std::size_t media_query_count() const { return media_queries_.size(); }
+
+private:
+    struct Entry {
+        CompiledRule rule;
+        // Index into media_queries_.
+        std::optional<std::size_t> media_query;
+    };
+
+    struct SelectorRef {
+        // The origin, specificity, and rule index packed together so that
+        // comparing these gives the cascade order.
+        std::uint64_t cascade_key{};
+        std::size_t rule{};
+        std::size_t selector{};
+        [[nodiscard]] constexpr auto operator<=>(SelectorRef const &) const = default;
+    };
+
+    using Bucket = std::vector<SelectorRef>;
+    using Buckets = std::map<std::string_view, Bucket, std::less<>>;
+
+    std::vector<Entry> rules_;
+    std::vector<css::MediaQuery const *> media_queries_;
+
+    // Every selector is put in exactly one bucket based on its rightmost
+    // compound selector, so only the buckets for an element's id, classes,
+    // and type (and the universal one) need to be checked when matching.
+    // The buckets are sorted by cascade key, highest first.
+    Buckets id_buckets_;
+    Buckets class_buckets_;
+    Buckets type_buckets_;
+    Bucket universal_bucket_;
+
+    // What changing the id, class, or attribute used as the key invalidates.
+    using Invalidations = std::map<std::string_view, Invalidation, std::less<>>;
+    Invalidations id_invalidations_;
+    Invalidations class_invalidations_;
+    Invalidations attribute_invalidations_;
+
+    void add_to_bucket(SelectorRef);
+    void add_invalidations(Selector const &, bool subject_is_element);
+};
+
+} // namespace style
+
+#endif
@@ -0,0 +1,194 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/rule_set.h"
+
+#include "style/ancestor_filter.h"
+#include "style/styled_node.h"
+
+#include "css/media_query.h"
+#include "css/rule.h"
+#include "css/style_sheet.h"
+#include "dom/dom.h"
+#include "etest/etest2.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("no media queries", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{{.selectors{"p"}}, {.selectors{"a"}}}};
+        style::RuleSet rule_set{stylesheet};
+        a.expect_eq(rule_set.media_query_count(), std::size_t{0});
+        a.expect_eq(rule_set.active_rules({}), std::vector{true, true});
+    });
+
+    s.add_test("media queries are deduplicated", [](etest::IActions &a) {
+        auto wide = css::MediaQuery{css::MediaQuery::Width{.min = 500}};
+        auto narrow = css::MediaQuery{css::MediaQuery::Width{.max = 499}};
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"p"}, .media_query{wide}},
+                {.selectors{"a"}, .media_query{wide}},
+                {.selectors{"div"}, .media_query{narrow}},
+                {.selectors{"span"}},
+                {.selectors{"b"}, .media_query{wide}},
+        }};
+
+        style::RuleSet rule_set{stylesheet};
+        a.expect_eq(rule_set.media_query_count(), std::size_t{2});
+    });
+
+    s.add_test("active rules", [](etest::IActions &a) {
+        auto wide = css::MediaQuery{css::MediaQuery::Width{.min = 500}};
+        auto narrow = css::MediaQuery{css::MediaQuery::Width{.max = 499}};
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"p"}, .media_query{wide}},
+                {.selectors{"div"}, .media_query{narrow}},
+                {.selectors{"span"}},
+                {.selectors{"b"}, .media_query{wide}},
+        }};
+
+        style::RuleSet rule_set{stylesheet};
+        a.expect_eq(rule_set.active_rules({.window_width = 600}), std::vector{true, false, true, true});
+        a.expect_eq(rule_set.active_rules({.window_width = 300}), std::vector{false, true, true, false});
+    });
+
+    s.add_test("matching rules, buckets", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"*"}},
+                {.selectors{"#main"}},
+                {.selectors{"p"}},
+                {.selectors{".a"}},
+                {.selectors{"div.b", "p.a"}},
+                {.selectors{"p::before"}},
+                {.selectors{"#other", ".c"}},
+                {.selectors{"span .a"}},
+                {.selectors{":root"}},
+        }};
+        style::RuleSet rule_set{stylesheet};
+        auto const active = rule_set.active_rules({});
+        auto const &r = stylesheet.rules;
+
+        dom::Element p{"p", {{"id", "main"}, {"class", "a  c a"}}};
+        style::StyledNode node{p};
+        // Cascade order: *, p, .a, .c, :root, p.a, #main
+        a.expect_eq(rule_set.matching_rules(node, active),
+                std::vector<css::Rule const *>{&r[0], &r[2], &r[3], &r[6], &r[8], &r[4], &r[1]});
+
+        dom::Element div{"div", {{"class", "b"}}};
+        style::StyledNode child{div, {}, {}, &node};
+        a.expect_eq(rule_set.matching_rules(child, active), std::vector<css::Rule const *>{&r[0], &r[4]});
+
+        style::StyledNode text{dom::Text{"hello"}};
+        a.expect(rule_set.matching_rules(text, active).empty());
+    });
+
+    s.add_test("matching rules, inactive rules", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"p"}, .media_query{css::MediaQuery{css::MediaQuery::Width{.min = 500}}}},
+                {.selectors{"p"}},
+        }};
+        style::RuleSet rule_set{stylesheet};
+
+        style::StyledNode node{dom::Element{"p"}};
+        a.expect_eq(rule_set.matching_rules(node, rule_set.active_rules({.window_width = 300})),
+                std::vector<css::Rule const *>{&stylesheet.rules[1]});
+        a.expect_eq(rule_set.matching_rules(node, rule_set.active_rules({.window_width = 600})),
+                std::vector<css::Rule const *>{&stylesheet.rules[0], &stylesheet.rules[1]});
+    });
+
+    s.add_test("matching rules, ancestor filter", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"div p"}},
+                {.selectors{".nope p"}},
+        }};
+        style::RuleSet rule_set{stylesheet};
+        auto const active = rule_set.active_rules({});
+
+        dom::Element div{"div"};
+        dom::Element p{"p"};
+        style::StyledNode parent{div};
+        style::StyledNode child{p, {}, {}, &parent};
+
+        style::AncestorFilter ancestors;
+        ancestors.push(div);
+        a.expect_eq(rule_set.matching_rules(child, active, &ancestors),
+                std::vector<css::Rule const *>{&stylesheet.rules[0]});
+
+        // The filter is trusted, so a filter missing the ancestors means no match.
+        style::AncestorFilter empty;
+        a.expect(rule_set.matching_rules(child, active, &empty).empty());
+    });
+
+    s.add_test("matching rules, cascade order", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"p.a"}},
+                {.selectors{"#b"}},
+                {.selectors{"p"}},
+                {.selectors{"p", "#b.a"}},
+                {.selectors{".a"}},
+                {.selectors{"p"}},
+        }};
+        style::RuleSet rule_set{stylesheet, 2};
+        auto const active = rule_set.active_rules({});
+        auto const &r = stylesheet.rules;
+
+        // The first two rules are user agent rules, and lose to everything else.
+        // A rule is placed according to its most specific matching selector.
+        style::StyledNode node{dom::Element{"p", {{"id", "b"}, {"class", "a"}}}};
+        a.expect_eq(rule_set.matching_rules(node, active),
+                std::vector<css::Rule const *>{&r[0], &r[1], &r[2], &r[5], &r[4], &r[3]});
+    });
+
+    s.add_test("matching rules, selector lists", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{"p", "p.a"}},
+                {.selectors{".a", "#b"}},
+                {.selectors{"*", "p"}},
+        }};
+        style::RuleSet rule_set{stylesheet};
+        auto const active = rule_set.active_rules({});
+        auto const &r = stylesheet.rules;
+
+        // Every selector matches, but each rule is only matched once.
+        style::StyledNode node{dom::Element{"p", {{"id", "b"}, {"class", "a"}}}};
+        a.expect_eq(rule_set.matching_rules(node, active), std::vector<css::Rule const *>{&r[2], &r[0], &r[1]});
+    });
+
+    s.add_test("invalidation", [](etest::IActions &a) {
+        css::StyleSheet stylesheet{.rules{
+                {.selectors{".a", "#b .c"}},
+                {.selectors{"[data-d] p", ":is(.e, .f div)"}},
+                {.selectors{":link"}},
+        }};
+        style::RuleSet rule_set{stylesheet};
+
+        using Invalidation = style::Invalidation;
+        dom::Element element{"div", {{"class", "a c f g"}, {"id", "b"}, {"data-d", ""}, {"href", ""}}};
+        auto invalidation = [&](std::string name, std::optional<std::string> old_value) {
+            return rule_set.invalidation({&element, std::move(name), std::move(old_value)});
+        };
+
+        // Only added or removed classes matter.
+        a.expect_eq(invalidation("class", "a c f g"), Invalidation{});
+        a.expect_eq(invalidation("class", "c f"), Invalidation{.element = true});
+        a.expect_eq(invalidation("class", "a f g"), Invalidation{.element = true});
+        a.expect_eq(invalidation("class", "a c g"), Invalidation{.descendants = true});
+        a.expect_eq(invalidation("class", "a c f"), Invalidation{});
+        a.expect_eq(invalidation("class", std::nullopt), Invalidation{true, true});
+
+        a.expect_eq(invalidation("id", "x"), Invalidation{.descendants = true});
+        a.expect_eq(invalidation("data-d", std::nullopt), Invalidation{.descendants = true});
+        a.expect_eq(invalidation("href", std::nullopt), Invalidation{.element = true});
+        a.expect_eq(invalidation("style", std::nullopt), Invalidation{.element = true});
+        a.expect_eq(invalidation("title", std::nullopt), Invalidation{});
+    });
+
+    return s.run();
+}
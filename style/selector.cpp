@@ -0,0 +1,477 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/selector.h"
+
+#include "style/ancestor_filter.h"
+#include "style/styled_node.h"
+
+#include "dom/dom.h"
+#include "util/string.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace style {
+namespace {
+
+bool contains_class(std::string_view classes, std::string_view needle_class) {
+    for (auto cls : classes | std::views::split(' ')) {
+        if (std::string_view{cls} == needle_class) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+constexpr bool is_ident_char(char c) {
+    constexpr std::string_view kNonIdentChars{".#[]:(),>+~*=\"'\\"};
+    return !util::is_whitespace(c) && !kNonIdentChars.contains(c);
+}
+
+// Finds the first `needle` that isn't inside parentheses or quotes.
+std::size_t find_top_level(std::string_view s, char needle) {
+    int depth = 0;
+    char quote = '\0';
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        auto c = s[i];
+        if (quote != '\0') {
+            if (c == quote) {
+                quote = '\0';
+            }
+        } else if (c == needle && depth == 0) {
+            return i;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            --depth;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+class SelectorParser {
+public:
+    explicit SelectorParser(std::string_view input) : input_{input} {}
+
+    // NOLINTNEXTLINE(misc-no-recursion)
+    std::optional<Selector> parse() {
+        Selector selector;
+
+        skip_whitespace();
+        while (true) {
+            auto compound = parse_compound();
+            if (!compound) {
+                return std::nullopt;
+            }
+
+            selector.compounds.push_back(*std::move(compound));
+
+            bool const had_whitespace = skip_whitespace();
+            if (is_eof()) {
+                break;
+            }
+
+            if (peek() == '>') {
+                advance(1);
+                skip_whitespace();
+                selector.combinators.push_back(Combinator::Child);
+            } else if (had_whitespace) {
+                // TODO(robinlinden): Sibling combinators. These currently fail
+                // when we try to parse them as the next compound selector.
+                selector.combinators.push_back(Combinator::Descendant);
+            } else {
+                return std::nullopt;
+            }
+        }
+
+        std::ranges::reverse(selector.compounds);
+        std::ranges::reverse(selector.combinators);
+        return selector;
+    }
+
+private:
+    std::string_view input_;
+    std::size_t pos_{};
+
+    constexpr bool is_eof() const { return pos_ >= input_.size(); }
+    constexpr char peek() const { return input_[pos_]; }
+    constexpr void advance(std::size_t n) { pos_ += n; }
+
+    constexpr bool consume_if(char c) {
+        if (is_eof() || peek() != c) {
+            return false;
+        }
+
+        advance(1);
+        return true;
+    }
+
+    // Returns true if any whitespace was skipped.
+    constexpr bool skip_whitespace() {
+        auto const start = pos_;
+        while (!is_eof() && util::is_whitespace(peek())) {
+            advance(1);
+        }
+
+        return pos_ != start;
+    }
+
+    constexpr std::optional<std::string_view> consume_ident() {
+        auto const start = pos_;
+        while (!is_eof() && is_ident_char(peek())) {
+            advance(1);
+        }
+
+        if (pos_ == start) {
+            return std::nullopt;
+        }
+
+        return input_.substr(start, pos_ - start);
+    }
+
+    // NOLINTNEXTLINE(misc-no-recursion)
+    std::optional<CompoundSelector> parse_compound() {
+        CompoundSelector compound;
+        auto const start = pos_;
+
+        if (consume_if('*')) {
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/Universal_selectors
+        } else if (auto type = consume_ident()) {
+            compound.type = *type;
+        }
+
+        while (!is_eof()) {
+            if (consume_if('#')) {
+                auto id = consume_ident();
+                if (!id || (compound.id.has_value() && compound.id != id)) {
+                    return std::nullopt;
+                }
+
+                compound.id = id;
+            } else if (consume_if('.')) {
+                auto cls = consume_ident();
+                if (!cls) {
+                    return std::nullopt;
+                }
+
+                compound.classes.push_back(*cls);
+            } else if (consume_if('[')) {
+                auto attribute = parse_attribute();
+                if (!attribute) {
+                    return std::nullopt;
+                }
+
+                compound.attributes.push_back(*attribute);
+            } else if (consume_if(':')) {
+                if (!parse_pseudo_class(compound)) {
+                    return std::nullopt;
+                }
+            } else {
+                break;
+            }
+        }
+
+        if (pos_ == start) {
+            return std::nullopt;
+        }
+
+        return compound;
+    }
+
+    // Called after the opening '['.
+    std::optional<AttributeSelector> parse_attribute() {
+        AttributeSelector attribute;
+
+        skip_whitespace();
+        auto name = consume_ident();
+        if (!name) {
+            return std::nullopt;
+        }
+
+        attribute.name = *name;
+        skip_whitespace();
+
+        if (consume_if('=')) {
+            attribute.op = AttributeSelector::Operator::Equals;
+            skip_whitespace();
+            if (is_eof()) {
+                return std::nullopt;
+            }
+
+            if (auto quote = peek(); quote == '"' || quote == '\'') {
+                advance(1);
+                auto end = input_.find(quote, pos_);
+                if (end == std::string_view::npos) {
+                    return std::nullopt;
+                }
+
+                attribute.value = input_.substr(pos_, end - pos_);
+                pos_ = end + 1;
+            } else if (auto value = consume_ident()) {
+                attribute.value = *value;
+            } else {
+                return std::nullopt;
+            }
+
+            skip_whitespace();
+        }
+
+        if (!consume_if(']')) {
+            return std::nullopt;
+        }
+
+        return attribute;
+    }
+
+    // Called after the ':'.
+    // NOLINTNEXTLINE(misc-no-recursion)
+    bool parse_pseudo_class(CompoundSelector &compound) {
+        auto name = consume_ident();
+        if (!name) {
+            // Most likely a pseudo-element, and those never match.
+            return false;
+        }
+
+        if (*name == "link" || *name == "any-link") {
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/:any-link
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/:link
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/:visited
+            // Ignoring :visited for now as we treat all links as unvisited.
+            compound.pseudo_classes.push_back(PseudoClass::Link);
+            return true;
+        }
+
+        if (*name == "root") {
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/:root
+            compound.pseudo_classes.push_back(PseudoClass::Root);
+            return true;
+        }
+
+        if (*name == "is" && consume_if('(')) {
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/:is
+            auto args = input_.substr(pos_);
+            auto end = find_top_level(args, ')');
+            if (end == std::string_view::npos) {
+                return false;
+            }
+
+            args = args.substr(0, end);
+            advance(end + 1);
+
+            // :is() takes a forgiving selector list, so invalid alternatives
+            // are dropped instead of invalidating the entire selector.
+            std::vector<Selector> alternatives;
+            while (true) {
+                auto comma = find_top_level(args, ',');
+                if (auto alternative = SelectorParser{args.substr(0, comma)}.parse()) {
+                    alternatives.push_back(*std::move(alternative));
+                }
+
+                if (comma == std::string_view::npos) {
+                    break;
+                }
+
+                args.remove_prefix(comma + 1);
+            }
+
+            compound.is.push_back(std::move(alternatives));
+            return true;
+        }
+
+        // Unhandled pseudo-classes never match.
+        return false;
+    }
+};
+
+bool is_match(dom::Element const &element, AttributeSelector const &attribute) {
+    auto it = element.attributes.find(attribute.name);
+    if (it == element.attributes.end()) {
+        return false;
+    }
+
+    switch (attribute.op) {
+        case AttributeSelector::Operator::Exists:
+            return true;
+        case AttributeSelector::Operator::Equals:
+            return it->second == attribute.value;
+    }
+
+    return false;
+}
+
+enum class MatchResult : std::uint8_t {
+    Matched,
+    // Some compound selector didn't match, but it may match further up in
+    // the tree if we're looking for it using a descendant combinator.
+    NotMatchedTryAncestors,
+    // We ran out of ancestors, so going further up the tree won't help.
+    NotMatchedGlobally,
+};
+
+// Without the NotMatchedGlobally short-circuit, a selector like
+// `p div div div` against a deep tree of divs w/o any p in it would try
+// every combination of ancestors before giving up.
+// NOLINTNEXTLINE(misc-no-recursion)
+MatchResult match(StyledNode const &node, Selector const &selector, std::size_t compound) {
+    if (!is_match(node, selector.compounds[compound])) {
+        return MatchResult::NotMatchedTryAncestors;
+    }
+
+    if (compound + 1 == selector.compounds.size()) {
+        return MatchResult::Matched;
+    }
+
+    auto const combinator = selector.combinators[compound];
+    for (auto const *ancestor = node.parent; ancestor != nullptr; ancestor = ancestor->parent) {
+        auto result = match(*ancestor, selector, compound + 1);
+        switch (combinator) {
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/Child_combinator
+            case Combinator::Child:
+                return result;
+            // https://developer.mozilla.org/en-US/docs/Web/CSS/Descendant_combinator
+            case Combinator::Descendant:
+                if (result != MatchResult::NotMatchedTryAncestors) {
+                    return result;
+                }
+                break;
+        }
+    }
+
+    return MatchResult::NotMatchedGlobally;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::uint32_t calculate_specificity(Selector const &selector) {
+    std::size_t ids = 0;
+    std::size_t classes = 0;
+    std::size_t types = 0;
+    for (auto const &compound : selector.compounds) {
+        ids += compound.id.has_value() ? 1 : 0;
+        classes += compound.classes.size() + compound.attributes.size() + compound.pseudo_classes.size();
+        types += compound.type.empty() ? 0 : 1;
+
+        // :is() gets the specificity of its most specific argument.
+        for (auto const &alternatives : compound.is) {
+            std::uint32_t most_specific = 0;
+            for (auto const &alternative : alternatives) {
+                most_specific = std::max(most_specific, calculate_specificity(alternative));
+            }
+
+            // Each count is added separately so that they saturate instead of overflowing into each other.
+            constexpr auto kMask = Selector::kMaxSpecificityCount;
+            constexpr auto kBits = Selector::kSpecificityBits;
+            ids += (most_specific >> (2 * kBits)) & kMask;
+            classes += (most_specific >> kBits) & kMask;
+            types += most_specific & kMask;
+        }
+    }
+
+    auto saturate = [](std::size_t count) {
+        return static_cast<std::uint32_t>(std::min<std::size_t>(count, Selector::kMaxSpecificityCount));
+    };
+
+    return (saturate(ids) << (2 * Selector::kSpecificityBits)) | (saturate(classes) << Selector::kSpecificityBits)
+            | saturate(types);
+}
+
+} // namespace
+
+std::optional<Selector> Selector::parse(std::string_view selector) {
+    auto compiled = SelectorParser{selector}.parse();
+    if (!compiled) {
+        return std::nullopt;
+    }
+
+    compiled->specificity = calculate_specificity(*compiled);
+
+    using Kind = AncestorFilter::Kind;
+    for (auto const &ancestor : compiled->compounds | std::views::drop(1)) {
+        if (!ancestor.type.empty()) {
+            compiled->ancestor_hashes.push_back(AncestorFilter::hash(Kind::Type, ancestor.type));
+        }
+
+        if (ancestor.id.has_value()) {
+            compiled->ancestor_hashes.push_back(AncestorFilter::hash(Kind::Id, *ancestor.id));
+        }
+
+        for (auto cls : ancestor.classes) {
+            compiled->ancestor_hashes.push_back(AncestorFilter::hash(Kind::Class, cls));
+        }
+    }
+
+    return compiled;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+bool is_match(StyledNode const &node, CompoundSelector const &compound) {
+    auto const *element = std::get_if<dom::Element>(&node.node);
+    if (element == nullptr) {
+        return false;
+    }
+
+    if (!compound.type.empty() && element->name != compound.type) {
+        return false;
+    }
+
+    if (compound.id.has_value()) {
+        auto it = element->attributes.find("id");
+        if (it == element->attributes.end() || it->second != *compound.id) {
+            return false;
+        }
+    }
+
+    if (!compound.classes.empty()) {
+        auto it = element->attributes.find("class");
+        if (it == element->attributes.end()) {
+            return false;
+        }
+
+        if (!std::ranges::all_of(compound.classes, [&](auto cls) { return contains_class(it->second, cls); })) {
+            return false;
+        }
+    }
+
+    if (!std::ranges::all_of(compound.attributes, [&](auto const &attr) { return is_match(*element, attr); })) {
+        return false;
+    }
+
+    for (auto pseudo_class : compound.pseudo_classes) {
+        switch (pseudo_class) {
+            case PseudoClass::Link:
+                if (!element->attributes.contains("href") || (element->name != "a" && element->name != "area")) {
+                    return false;
+                }
+                break;
+            case PseudoClass::Root:
+                if (node.parent != nullptr) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    // NOLINTNEXTLINE(misc-no-recursion)
+    return std::ranges::all_of(compound.is, [&](auto const &alternatives) {
+        return std::ranges::any_of(alternatives, [&](auto const &selector) { return is_match(node, selector); });
+    });
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+bool is_match(StyledNode const &node, Selector const &selector) {
+    return match(node, selector, 0) == MatchResult::Matched;
+}
+
+} // namespace style
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#ifndef STYLE_SELECTOR_H_
+#define STYLE_SELECTOR_H_
+
+#include "style/styled_node.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace style {
+
+struct Selector;
+
+// https://developer.mozilla.org/en-US/docs/Web/CSS/Attribute_selectors
+struct AttributeSelector {
+    enum class Operator : std::uint8_t {
+        Exists, // [attr]
+        Equals, // [attr=value]
+    };
+
+    std::string_view name;
+    Operator op{Operator::Exists};
+    std::string_view value;
+};
+
+// https://developer.mozilla.org/en-US/docs/Web/CSS/Pseudo-classes
+enum class PseudoClass : std::uint8_t {
+    // :link and :any-link. These are identical as we treat all links as unvisited.
+    Link,
+    Root,
+};
+
+// Something like `a.cls#id[attr]:link`. Everything in here has to match.
+struct CompoundSelector {
+    // Empty for the universal selector.
+    std::string_view type;
+    std::optional<std::string_view> id;
+    std::vector<std::string_view> classes;
+    std::vector<AttributeSelector> attributes;
+    std::vector<PseudoClass> pseudo_classes;
+    // :is(...), one of the alternatives in each list has to match.
+    std::vector<std::vector<Selector>> is;
+};
+
+enum class Combinator : std::uint8_t {
+    Descendant,
+    Child,
+};
+
+// A selector compiled once so that matching it doesn't require any parsing.
+// All strings point into the selector text passed to parse(), so that has to
+// outlive this.
+struct Selector {
+    // Rightmost first, so compounds[0] is what the element itself has to match.
+    std::vector<CompoundSelector> compounds;
+    // combinators[i] is the relation between compounds[i] and compounds[i + 1].
+    std::vector<Combinator> combinators;
+    // AncestorFilter hashes of the types, ids, and classes some ancestor must have.
+    std::vector<std::uint32_t> ancestor_hashes;
+    // https://www.w3.org/TR/selectors-4/#specificity-rules
+    // The id, class, and type counts packed w/ 10 bits each, so that
+    // specificities can be compared as integers.
+    std::uint32_t specificity{};
+
+    static constexpr std::uint32_t kSpecificityBits = 10;
+    static constexpr std::uint32_t kMaxSpecificityCount = (1 << kSpecificityBits) - 1;
+
+    // Returns nullopt for selectors we don't support. These should never match.
+    static std::optional<Selector> parse(std::string_view);
+};
+
+bool is_match(StyledNode const &, Selector const &);
+bool is_match(StyledNode const &, CompoundSelector const &);
+
+} // namespace style
+
+#endif
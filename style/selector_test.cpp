@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2026 Robin Lindén <dev@robinlinden.eu>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "style/selector.h"
+
+#include "style/ancestor_filter.h"
+#include "style/styled_node.h"
+
+#include "dom/dom.h"
+#include "etest/etest2.h"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+bool is_match(style::StyledNode const &node, std::string_view selector) {
+    auto compiled = style::Selector::parse(selector);
+    return compiled.has_value() && style::is_match(node, *compiled);
+}
+} // namespace
+
+int main() {
+    etest::Suite s;
+
+    s.add_test("parse: compound", [](etest::IActions &a) {
+        auto selector = style::Selector::parse("div#main.a.b[data-x='y z']:root");
+        a.require(selector.has_value());
+        a.require_eq(selector->compounds.size(), std::size_t{1});
+        a.expect(selector->combinators.empty());
+
+        auto const &compound = selector->compounds[0];
+        a.expect_eq(compound.type, "div"sv);
+        a.expect_eq(compound.id, std::optional{"main"sv});
+        a.expect_eq(compound.classes, std::vector{"a"sv, "b"sv});
+        a.require_eq(compound.attributes.size(), std::size_t{1});
+        a.expect_eq(compound.attributes[0].name, "data-x"sv);
+        a.expect_eq(compound.attributes[0].value, "y z"sv);
+        a.expect_eq(compound.pseudo_classes, std::vector{style::PseudoClass::Root});
+    });
+
+    s.add_test("parse: combinators", [](etest::IActions &a) {
+        auto selector = style::Selector::parse("  .a  > b c>d ");
+        a.require(selector.has_value());
+        a.require_eq(selector->compounds.size(), std::size_t{4});
+        a.expect_eq(selector->compounds[0].type, "d"sv);
+        a.expect_eq(selector->compounds[1].type, "c"sv);
+        a.expect_eq(selector->compounds[2].type, "b"sv);
+        a.expect_eq(selector->compounds[3].classes, std::vector{"a"sv});
+        a.expect_eq(selector->combinators,
+                std::vector{style::Combinator::Child, style::Combinator::Descendant, style::Combinator::Child});
+    });
+
+    s.add_test("parse: unsupported", [](etest::IActions &a) {
+        a.expect(!style::Selector::parse("").has_value());
+        a.expect(!style::Selector::parse("a + b").has_value());
+        a.expect(!style::Selector::parse("a ~ b").has_value());
+        a.expect(!style::Selector::parse("a >").has_value());
+        a.expect(!style::Selector::parse("p::before").has_value());
+        a.expect(!style::Selector::parse("p:hover").has_value());
+        a.expect(!style::Selector::parse("[a~=b]").has_value());
+        a.expect(!style::Selector::parse("#a#b").has_value());
+        a.expect(!style::Selector::parse(":is(a").has_value());
+    });
+
+    s.add_test("is_match: mixed combinators", [](etest::IActions &a) {
+        // DOM for div.a { p { span { b } } }
+        dom::Element dom{"div",
+                {{"class", "a"}},
+                {dom::Element{"p", {}, {dom::Element{"span", {}, {dom::Element{"b"}}}}}}};
+        auto const &p = std::get<dom::Element>(dom.children[0]);
+        auto const &span = std::get<dom::Element>(p.children[0]);
+
+        style::StyledNode div_node{dom};
+        style::StyledNode p_node{p, {}, {}, &div_node};
+        style::StyledNode span_node{span, {}, {}, &p_node};
+        style::StyledNode b_node{span.children[0], {}, {}, &span_node};
+
+        a.expect(is_match(b_node, ".a > p b"));
+        a.expect(is_match(b_node, ".a p > span > b"));
+        a.expect(is_match(b_node, "div span > b"));
+        a.expect(!is_match(b_node, ".a > span b"));
+        a.expect(!is_match(b_node, "p > b"));
+        a.expect(is_match(b_node, ":is(p, i) b"));
+        a.expect(!is_match(b_node, ":is(i, em) b"));
+    });
+
+    s.add_test("is_match: compound", [](etest::IActions &a) {
+        style::StyledNode node{dom::Element{"div", {{"id", "x"}, {"class", "a b"}, {"type", "text"}}}};
+        a.expect(is_match(node, "div#x"));
+        a.expect(is_match(node, "div#x.b.a"));
+        a.expect(is_match(node, "*#x"));
+        a.expect(is_match(node, "[type=\"text\"]"));
+        a.expect(is_match(node, "div[type='text'].a"));
+        a.expect(!is_match(node, "div#y"));
+        a.expect(!is_match(node, "p#x"));
+        a.expect(!is_match(node, "div[type=texts]"));
+    });
+
+    s.add_test("is_match: :is() drops invalid alternatives", [](etest::IActions &a) {
+        style::StyledNode node{dom::Element{"a"}};
+        a.expect(is_match(node, ":is(:hover, a)"));
+        a.expect(!is_match(node, ":is(:hover)"));
+    });
+
+    s.add_test("is_match: deep tree, no match", [](etest::IActions &a) {
+        // Backtracking through every combination of ancestors would take forever here.
+        dom::Node div = dom::Element{"div"};
+        std::vector<style::StyledNode> nodes(200, style::StyledNode{div});
+        for (std::size_t i = 1; i < nodes.size(); ++i) {
+            nodes[i].parent = &nodes[i - 1];
+        }
+
+        a.expect(!is_match(nodes.back(), "p div div div div div div div div div div div div"));
+        a.expect(is_match(nodes.back(), "div div div div div div div div div div div div"));
+        a.expect(!is_match(nodes.back(), "p > div div div div div div div div div div div"));
+    });
+
+    s.add_test("parse: ancestor hashes", [](etest::IActions &a) {
+        using Kind = style::AncestorFilter::Kind;
+        auto selector = style::Selector::parse("div#a.b > :is(p) span");
+        a.require(selector.has_value());
+        a.expect_eq(selector->ancestor_hashes,
+                std::vector{
+                        style::AncestorFilter::hash(Kind::Type, "div"),
+                        style::AncestorFilter::hash(Kind::Id, "a"),
+                        style::AncestorFilter::hash(Kind::Class, "b"),
+                });
+
+        a.expect(style::Selector::parse(".a")->ancestor_hashes.empty());
+    });
+
+    s.add_test("parse: specificity", [](etest::IActions &a) {
+        auto specificity = [](std::string_view selector) { return style::Selector::parse(selector)->specificity; };
+        constexpr auto kIds = 1u << 20;
+        constexpr auto kClasses = 1u << 10;
+        constexpr auto kTypes = 1u;
+
+        a.expect_eq(specificity("*"), 0u);
+        a.expect_eq(specificity("p"), kTypes);
+        a.expect_eq(specificity("div > p a"), 3 * kTypes);
+        a.expect_eq(specificity("a.b.c[href]:link"), 4 * kClasses + kTypes);
+        a.expect_eq(specificity("#a p.b"), kIds + kClasses + kTypes);
+        a.expect_eq(specificity(":is(p, #a, .b.c) span"), kIds + kTypes);
+        a.expect(specificity("#a") > specificity(".a.b.c.d.e.f.g.h.i.j.k.l"));
+    });
+
+    return s.run();
+}
@@ -1,284 +1,480 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #include "style/style.h"
 
+#include "style/ancestor_filter.h"
+#include "style/computed_style.h"
+#include "style/inline_style_cache.h"
+#include "style/rule_set.h"
+#include "style/selector.h"
 #include "style/styled_node.h"
 
 #include "css/media_query.h"
-#include "css/parser.h"
 #include "css/property_id.h"
+#include "css/rule.h"
 #include "css/style_sheet.h"
 #include "dom/dom.h"
-#include "util/string.h"
-
-#include <spdlog/spdlog.h>
+#include "dom/mutation_log.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <future>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
 
-using namespace std::literals;
-
 namespace style {
+
+bool is_match(style::StyledNode const &node, std::string_view selector) {
+    auto compiled = Selector::parse(selector);
+    return compiled.has_value() && is_match(node, *compiled);
+}
+
 namespace {
-bool contains_class(std::string_view classes, std::string_view needle_class) {
-    for (auto cls : classes | std::views::split(' ')) {
-        if (std::string_view{cls} == needle_class) {
-            return true;
+// What's needed to style a tree that stays the same during the entire pass.
+struct StylingPass {
+    RuleSet const &rule_set;
+    RuleSet::ActiveRules active_rules;
+    InlineStyleCache &inline_styles;
+};
+
+MatchingProperties matching_properties(
+        style::StyledNode const &node, StylingPass const &pass, AncestorFilter const *ancestors) {
+    std::vector<std::pair<css::PropertyId, std::string>> matched_properties;
+    std::vector<std::pair<std::string, std::string>> matched_custom_properties;
+
+    auto const matched_rules = pass.rule_set.matching_rules(node, pass.active_rules, ancestors);
+    for (auto const *rule : matched_rules) {
+        std::ranges::copy(rule->declarations, std::back_inserter(matched_properties));
+        std::ranges::copy(rule->custom_properties, std::back_inserter(matched_custom_properties));
+    }
+
+    if (auto const *element = std::get_if<dom::Element>(&node.node)) {
+        auto style_attr = element->attributes.find("style");
+        if (style_attr != element->attributes.end()) {
+            if (auto const *element_style = pass.inline_styles.get(style_attr->second)) {
+                std::ranges::copy(element_style->declarations, std::back_inserter(matched_properties));
+                std::ranges::copy(element_style->important_declarations, std::back_inserter(matched_properties));
+                std::ranges::copy(element_style->custom_properties, std::back_inserter(matched_custom_properties));
+            }
         }
     }
 
-    return false;
+    // TODO(robinlinden): !important inline styles should override the ones from
+    // the style sheets.
+    for (auto const *rule : matched_rules) {
+        std::ranges::copy(rule->important_declarations, std::back_inserter(matched_properties));
+    }
+
+    return {std::move(matched_properties), std::move(matched_custom_properties)};
 }
 } // namespace
 
-// TODO(robinlinden): This needs to match more things.
-// NOLINTNEXTLINE(misc-no-recursion)
-bool is_match(style::StyledNode const &node, std::string_view selector) {
-    auto const &element = std::get<dom::Element>(node.node);
-    // https://developer.mozilla.org/en-US/docs/Web/CSS/Pseudo-classes
-    auto [selector_, psuedo_class] = util::split_once(selector, ':');
-
-    // https://developer.mozilla.org/en-US/docs/Web/CSS/Child_combinator
-    if (selector_.contains('>')) {
-        // TODO(robinlinden): std::views::reverse and friends when we drop Clang 14 and 15.
-        auto parts = util::split(selector_, ">");
-        selector_ = util::trim(parts.back());
-        parts.pop_back();
-        std::ranges::reverse(parts);
-
-        // We only check the parent and up here, and if they all match, we fall
-        // through and check this node.
-        auto const *current = node.parent;
-        for (auto part : parts) {
-            part = util::trim(part);
-            // TODO(robinlinden): Handle descendant and child combinators in the same selector.
-            if (part.contains(' ')) {
-                return false;
-            }
+MatchingProperties matching_properties(
+        style::StyledNode const &node, css::StyleSheet const &stylesheet, css::MediaQuery::Context const &ctx) {
+    RuleSet const rule_set{stylesheet};
+    InlineStyleCache inline_styles;
+    return matching_properties(node, {rule_set, rule_set.active_rules(ctx), inline_styles}, nullptr);
+}
 
-            if (current == nullptr || !is_match(*current, part)) {
-                return false;
+namespace {
+// Siblings w/ the same name and attributes match exactly the same rules since
+// they also share all their ancestors, so the last few styled siblings are
+// kept around to copy the matched properties from. This is what makes long
+// lists and tables cheap to style.
+class SiblingStyleCache {
+public:
+    StyledNode const *find(dom::Element const &element) const {
+        // Ids are supposed to be unique, so these will never find anything to share with.
+        if (element.attributes.contains("id")) {
+            return nullptr;
+        }
+
+        for (auto const *candidate : candidates_) {
+            if (candidate == nullptr) {
+                break;
             }
 
-            current = current->parent;
+            auto const &candidate_element = std::get<dom::Element>(candidate->node);
+            if (candidate_element.name == element.name && candidate_element.attributes == element.attributes) {
+                return candidate;
+            }
         }
+
+        return nullptr;
     }
 
-    // https://developer.mozilla.org/en-US/docs/Web/CSS/Descendant_combinator
-    if (selector_.contains(' ')) {
-        // TODO(robinlinden): std::views::reverse and friends when we drop Clang 14 and 15.
-        auto parts = util::split(selector_, " ");
-        selector_ = util::trim(parts.back());
-        parts.pop_back();
-        std::ranges::reverse(parts);
-
-        // We only check the parent and up here, and if they all match, we fall
-        // through and check this node.
-        auto const *current = node.parent;
-        for (auto const &part : parts) {
-            while (current != nullptr && !is_match(*current, util::trim(part))) {
-                current = current->parent;
-            }
+    void add(StyledNode const &node) {
+        candidates_[next_] = &node;
+        next_ = (next_ + 1) % candidates_.size();
+    }
 
-            if (current == nullptr) {
-                return false;
-            }
+private:
+    std::array<StyledNode const *, 8> candidates_{};
+    std::size_t next_{};
+};
+
+void style_element(StyledNode &node,
+        StylingPass const &pass,
+        AncestorFilter const &ancestors,
+        ComputedStyle::Cache &computed_styles) {
+    auto [normal, custom] = matching_properties(node, pass, &ancestors);
+    node.properties = std::move(normal);
+    node.custom_properties = std::move(custom);
+    node.compute_properties(&computed_styles);
+}
 
-            current = current->parent;
+// Subtrees smaller than this aren't worth starting a new thread for.
+constexpr std::size_t kMinParallelSubtreeSize = 512;
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::size_t count_subtree_sizes(dom::Node const &node, std::vector<std::size_t> &sizes) {
+    auto const index = sizes.size();
+    sizes.push_back(1);
+    if (auto const *element = std::get_if<dom::Element>(&node)) {
+        for (auto const &child : element->children) {
+            sizes[index] += count_subtree_sizes(child, sizes);
         }
     }
 
-    if (!psuedo_class.empty()) {
-        if (psuedo_class == "link" || psuedo_class == "any-link") {
-            // https://developer.mozilla.org/en-US/docs/Web/CSS/:any-link
-            // https://developer.mozilla.org/en-US/docs/Web/CSS/:link
-            // https://developer.mozilla.org/en-US/docs/Web/CSS/:visited
-            // Ignoring :visited for now as we treat all links as unvisited.
-            if (!element.attributes.contains("href")) {
-                return false;
-            }
+    return sizes[index];
+}
 
-            if (element.name != "a" && element.name != "area") {
-                return false;
-            }
+// Shared by all threads taking part in styling a tree in parallel.
+class ParallelStyling {
+public:
+    ParallelStyling(dom::Node const &root, std::size_t max_threads)
+        : spare_threads_{static_cast<std::ptrdiff_t>(max_threads) - 1} {
+        count_subtree_sizes(root, subtree_sizes_);
+    }
 
-            if (selector_.empty()) {
-                return true;
-            }
-        } else if (psuedo_class == "root") {
-            // https://developer.mozilla.org/en-US/docs/Web/CSS/:root
-            if (node.parent != nullptr) {
-                return false;
-            }
+    // The size of the subtree rooted at the node w/ this index in a pre-order traversal.
+    std::size_t subtree_size(std::size_t preorder_index) const { return subtree_sizes_[preorder_index]; }
 
-            if (selector_.empty()) {
+    bool try_acquire_thread() {
+        auto spare = spare_threads_.load(std::memory_order_relaxed);
+        while (spare > 0) {
+            if (spare_threads_.compare_exchange_weak(spare, spare - 1, std::memory_order_relaxed)) {
                 return true;
             }
-        } else if (psuedo_class.starts_with("is(")) {
-            // https://developer.mozilla.org/en-US/docs/Web/CSS/:is
-            psuedo_class.remove_prefix(3);
-            auto [alternatives, rest] = util::split_once(psuedo_class, ')');
-            if (!rest.empty()) {
-                // TODO(robinlinden): Handle.
-                return false;
-            }
+        }
+
+        return false;
+    }
+
+    void release_thread() { spare_threads_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::vector<std::size_t> subtree_sizes_;
+    std::atomic<std::ptrdiff_t> spare_threads_;
+};
+
+// What a single thread needs to style the subtrees below some node.
+struct SubtreeContext {
+    StylingPass const &pass;
+    ParallelStyling *parallel{};
+    AncestorFilter ancestors;
+    ComputedStyle::Cache computed_styles;
+};
+
+// Styles the children of `current`, which must already be styled itself.
+// NOLINTNEXTLINE(misc-no-recursion)
+void style_tree_impl(StyledNode &current, std::size_t preorder_index, SubtreeContext &ctx) {
+    auto const *element = std::get_if<dom::Element>(&current.node);
+    if (element == nullptr) {
+        return;
+    }
+
+    ctx.ancestors.push(*element);
+    // No reallocations are allowed after this as the sibling cache and the
+    // children's parent pointers point into the vector.
+    current.children.reserve(element->children.size());
+    SiblingStyleCache siblings;
+    for (auto const &child : element->children) {
+        auto &child_node = current.children.emplace_back(child);
+        child_node.parent = &current;
 
-            // NOLINTNEXTLINE(misc-no-recursion)
-            if (std::ranges::none_of(alternatives | std::views::split(','), [&](auto const &alternative) {
-                    return is_match(node, util::trim(std::string_view{alternative})); //
-                })) {
-                return false;
+        if (auto const *child_element = std::get_if<dom::Element>(&child)) {
+            if (auto const *sibling = siblings.find(*child_element)) {
+                child_node.properties = sibling->properties;
+                child_node.custom_properties = sibling->custom_properties;
+                child_node.computed = sibling->computed;
+            } else {
+                style_element(child_node, ctx.pass, ctx.ancestors, ctx.computed_styles);
+                siblings.add(child_node);
             }
-        } else {
-            // Unhandled psuedo-classes never match.
-            return false;
         }
+    }
 
-        if (selector_.empty()) {
-            return true;
+    // All children are styled, so their subtrees can be styled independently
+    // of each other.
+    if (ctx.parallel == nullptr) {
+        for (auto &child_node : current.children) {
+            style_tree_impl(child_node, 0, ctx);
         }
-    }
 
-    // https://developer.mozilla.org/en-US/docs/Web/CSS/Universal_selectors
-    if (selector_ == "*") {
-        return true;
+        ctx.ancestors.pop(*element);
+        return;
     }
 
-    if (element.name == selector_) {
-        return true;
-    }
+    // Split the children into runs of subtrees large enough to be worth
+    // handing off to other threads. The first run is always kept on this
+    // thread, as are the ones we don't have any spare threads for.
+    struct Run {
+        std::size_t begin{};
+        std::size_t end{};
+        std::size_t preorder_index{};
+    };
+
+    std::vector<Run> runs;
+    std::size_t run_size = 0;
+    auto child_index = preorder_index + 1;
+    for (std::size_t i = 0; i < current.children.size(); ++i) {
+        if (run_size == 0) {
+            runs.push_back({i, i, child_index});
+        }
 
-    auto class_position = selector_.find('.');
-    if (class_position != std::string_view::npos) {
-        auto class_attr = element.attributes.find("class");
-        if (class_attr == element.attributes.end()) {
-            return false;
+        auto const size = ctx.parallel->subtree_size(child_index);
+        child_index += size;
+        run_size += size;
+        runs.back().end = i + 1;
+        if (run_size >= kMinParallelSubtreeSize) {
+            run_size = 0;
         }
+    }
 
-        auto class_string = selector_.substr(class_position);
-        if (class_position != 0 && selector_.substr(0, class_position) != element.name) {
-            return false;
+    // NOLINTNEXTLINE(misc-no-recursion)
+    auto style_run = [&current](Run const &run, SubtreeContext &run_ctx) {
+        auto index = run.preorder_index;
+        for (std::size_t i = run.begin; i < run.end; ++i) {
+            style_tree_impl(current.children[i], index, run_ctx);
+            index += run_ctx.parallel->subtree_size(index);
         }
+    };
 
-        class_string.remove_prefix(1);
-        for (auto cls : class_string | std::views::split('.')) {
-            if (!contains_class(class_attr->second, std::string_view{cls})) {
-                return false;
-            }
+    std::vector<std::future<void>> spawned;
+    std::vector<Run const *> kept;
+    for (auto const &run : runs) {
+        if (&run == &runs.front() || !ctx.parallel->try_acquire_thread()) {
+            kept.push_back(&run);
+            continue;
         }
 
-        return true;
+        // NOLINTNEXTLINE(misc-no-recursion)
+        spawned.push_back(std::async(std::launch::async, [&, ancestors = ctx.ancestors] {
+            SubtreeContext run_ctx{ctx.pass, ctx.parallel, ancestors, {}};
+            style_run(run, run_ctx);
+            run_ctx.parallel->release_thread();
+        }));
     }
 
-    if (selector_.starts_with('#')) {
-        auto it = element.attributes.find("id");
-        selector_.remove_prefix(1);
-        return it != element.attributes.end() && it->second == selector_;
+    for (auto const *run : kept) {
+        style_run(*run, ctx);
     }
+    ctx.ancestors.pop(*element);
 
-    // https://developer.mozilla.org/en-US/docs/Web/CSS/Attribute_selectors
-    if (selector_.starts_with('[') && selector_.contains(']')) {
-        selector_.remove_prefix(1);
-        auto [attr, rest] = util::split_once(selector_, ']');
-        if (!rest.empty() && !is_match(node, rest)) {
-            return false;
-        }
+    for (auto &future : spawned) {
+        future.get();
+    }
+}
 
-        auto [key, value] = util::split_once(attr, '=');
-        if (value.empty()) {
-            return element.attributes.contains(key);
-        }
+std::unique_ptr<StyledNode> style_tree_impl(dom::Node const &root,
+        RuleSet const &rule_set,
+        InlineStyleCache &inline_styles,
+        css::MediaQuery::Context const &ctx,
+        ParallelStyling *parallel) {
+    StylingPass const pass{rule_set, rule_set.active_rules(ctx), inline_styles};
+    SubtreeContext subtree_ctx{pass, parallel, {}, {}};
+    auto tree_root = std::make_unique<StyledNode>(root);
+    if (std::holds_alternative<dom::Element>(root)) {
+        style_element(*tree_root, pass, subtree_ctx.ancestors, subtree_ctx.computed_styles);
+    }
+
+    style_tree_impl(*tree_root, 0, subtree_ctx);
+    return tree_root;
+}
+} // namespace
 
-        auto it = element.attributes.find(key);
-        return it != element.attributes.end() && it->second == value;
+std::unique_ptr<StyledNode> style_tree(
+        dom::Node const &root, css::StyleSheet const &stylesheet, css::MediaQuery::Context const &ctx) {
+    return style_tree(root, RuleSet{stylesheet}, ctx);
+}
+
+std::unique_ptr<StyledNode> style_tree(
+        dom::Node const &root, RuleSet const &rule_set, css::MediaQuery::Context const &ctx) {
+    InlineStyleCache inline_styles;
+    return style_tree(root, rule_set, inline_styles, ctx);
+}
+
+std::unique_ptr<StyledNode> style_tree(dom::Node const &root,
+        RuleSet const &rule_set,
+        InlineStyleCache &inline_styles,
+        css::MediaQuery::Context const &ctx) {
+    return style_tree_impl(root, rule_set, inline_styles, ctx, nullptr);
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+void index_styled_elements(StyledNode &node, StyledElements &elements) {
+    auto const *element = std::get_if<dom::Element>(&node.node);
+    if (element == nullptr) {
+        return;
     }
 
-    return false;
+    elements.emplace(element, &node);
+    for (auto &child : node.children) {
+        index_styled_elements(child, elements);
+    }
 }
 
-MatchingProperties matching_properties(
-        style::StyledNode const &node, css::StyleSheet const &stylesheet, css::MediaQuery::Context const &ctx) {
-    std::vector<std::pair<css::PropertyId, std::string>> matched_properties;
-    std::vector<std::pair<std::string, std::string>> matched_custom_properties;
+namespace {
+struct RestyleContext {
+    StylingPass const &pass;
+    // Removed from as the elements are restyled.
+    std::map<dom::Element const *, Invalidation> invalidations;
+    AncestorFilter ancestors;
+    ComputedStyle::Cache computed_styles;
+    std::size_t rematched{};
+    std::vector<StyledNode const *> *restyled{};
+};
 
-    for (auto const &rule : stylesheet.rules) {
-        if (rule.media_query.has_value() && !rule.media_query->evaluate(ctx)) {
-            continue;
+// NOLINTNEXTLINE(misc-no-recursion)
+void restyle_impl(StyledNode &node, RestyleContext &ctx, bool parent_changed, bool rematch) {
+    auto const *element = std::get_if<dom::Element>(&node.node);
+    if (element == nullptr) {
+        return;
+    }
+
+    Invalidation invalidation{.element = rematch, .descendants = rematch};
+    if (auto it = ctx.invalidations.find(element); it != ctx.invalidations.end()) {
+        invalidation |= it->second;
+        ctx.invalidations.erase(it);
+    }
+
+    bool changed = false;
+    if (invalidation.element || parent_changed) {
+        auto const old = std::move(node.computed);
+        if (invalidation.element) {
+            style_element(node, ctx.pass, ctx.ancestors, ctx.computed_styles);
+            ++ctx.rematched;
+        } else {
+            node.compute_properties(&ctx.computed_styles);
         }
 
-        if (std::ranges::any_of(rule.selectors, [&](auto const &selector) { return is_match(node, selector); })) {
-            std::ranges::copy(rule.declarations, std::back_inserter(matched_properties));
-            std::ranges::copy(rule.custom_properties, std::back_inserter(matched_custom_properties));
+        changed = !(node.computed == old);
+        if (changed && ctx.restyled != nullptr) {
+            ctx.restyled->push_back(&node);
         }
     }
 
-    if (auto const *element = std::get_if<dom::Element>(&node.node)) {
-        auto style_attr = element->attributes.find("style");
-        if (style_attr != element->attributes.end()) {
-            // TODO(robinlinden): Incredibly hacky, but our //css parser doesn't support
-            // parsing only declarations. Replace with the //css2 parser once possible.
-            auto element_style = css::parse("dummy{"s + style_attr->second + "}"s).rules;
-            // The above should always parse to 1 rule when using the old parser.
-            if (element_style.size() == 1) {
-                std::ranges::copy(element_style[0].declarations, std::back_inserter(matched_properties));
-                std::ranges::copy(element_style[0].important_declarations, std::back_inserter(matched_properties));
-                std::ranges::copy(element_style[0].custom_properties, std::back_inserter(matched_custom_properties));
-            } else {
-                spdlog::warn("Failed to parse inline style '{}' for element '{}'", style_attr->second, element->name);
-            }
+    // Nothing below this is affected by it. Any invalidated elements further
+    // down are restyled on their own.
+    if (!changed && !invalidation.descendants) {
+        return;
+    }
+
+    ctx.ancestors.push(*element);
+    for (auto &child : node.children) {
+        restyle_impl(child, ctx, changed, invalidation.descendants);
+    }
+    ctx.ancestors.pop(*element);
+}
+} // namespace
+
+std::size_t restyle(StyledNode &root,
+        RuleSet const &rule_set,
+        InlineStyleCache &inline_styles,
+        std::span<dom::AttributeChange const> changes,
+        css::MediaQuery::Context const &ctx,
+        std::vector<StyledNode const *> *restyled) {
+    StyledElements elements;
+    index_styled_elements(root, elements);
+    return restyle(elements, rule_set, inline_styles, changes, ctx, restyled);
+}
+
+std::size_t restyle(StyledElements const &elements,
+        RuleSet const &rule_set,
+        InlineStyleCache &inline_styles,
+        std::span<dom::AttributeChange const> changes,
+        css::MediaQuery::Context const &ctx,
+        std::vector<StyledNode const *> *restyled) {
+    std::map<dom::Element const *, Invalidation> invalidations;
+    for (auto const &change : changes) {
+        if (auto invalidation = rule_set.invalidation(change); invalidation != Invalidation{}) {
+            invalidations[change.element] |= invalidation;
         }
     }
 
-    // TODO(robinlinden): !important inline styles should override the ones from
-    // the style sheets.
-    for (auto const &rule : stylesheet.rules) {
-        if (rule.important_declarations.empty() || (rule.media_query.has_value() && !rule.media_query->evaluate(ctx))) {
+    // Nothing any selector cares about changed.
+    if (invalidations.empty()) {
+        return 0;
+    }
+
+    // Ancestors are restyled before their descendants, as those may inherit
+    // from them, so the invalidated elements are sorted by their depth.
+    std::vector<std::pair<std::size_t, StyledNode *>> invalidated;
+    for (auto const &[element, unused] : invalidations) {
+        auto it = elements.find(element);
+        if (it == elements.end()) {
             continue;
         }
 
-        if (std::ranges::any_of(rule.selectors, [&](auto const &selector) { return is_match(node, selector); })) {
-            std::ranges::copy(rule.important_declarations, std::back_inserter(matched_properties));
+        std::size_t depth = 0;
+        for (auto const *current = it->second->parent; current != nullptr; current = current->parent) {
+            ++depth;
         }
+        invalidated.emplace_back(depth, it->second);
     }
+    std::ranges::sort(invalidated);
+
+    StylingPass const pass{rule_set, rule_set.active_rules(ctx), inline_styles};
+    RestyleContext restyle_ctx{pass, std::move(invalidations), {}, {}, {}, restyled};
+    std::vector<dom::Element const *> ancestors;
+    for (auto [unused, node] : invalidated) {
+        // Already restyled along w/ one of its ancestors.
+        if (!restyle_ctx.invalidations.contains(&std::get<dom::Element>(node->node))) {
+            continue;
+        }
 
-    return {std::move(matched_properties), std::move(matched_custom_properties)};
-}
+        ancestors.clear();
+        for (auto const *current = node->parent; current != nullptr; current = current->parent) {
+            ancestors.push_back(&std::get<dom::Element>(current->node));
+        }
 
-namespace {
-// NOLINTNEXTLINE(misc-no-recursion)
-void style_tree_impl(StyledNode &current, css::StyleSheet const &stylesheet, css::MediaQuery::Context const &ctx) {
-    auto const *element = std::get_if<dom::Element>(&current.node);
-    if (element == nullptr) {
-        return;
-    }
+        for (auto const *ancestor : std::views::reverse(ancestors)) {
+            restyle_ctx.ancestors.push(*ancestor);
+        }
 
-    current.children.reserve(element->children.size());
-    for (auto const &child : element->children) {
-        auto &child_node = current.children.emplace_back(child);
-        child_node.parent = &current;
-        style_tree_impl(child_node, stylesheet, ctx);
+        restyle_impl(*node, restyle_ctx, false, false);
+        for (auto const *ancestor : ancestors) {
+            restyle_ctx.ancestors.pop(*ancestor);
+        }
     }
 
-    auto [normal, custom] = matching_properties(current, stylesheet, ctx);
-    current.properties = std::move(normal);
-    current.custom_properties = std::move(custom);
+    return restyle_ctx.rematched;
 }
-} // namespace
 
-std::unique_ptr<StyledNode> style_tree(
-        dom::Node const &root, css::StyleSheet const &stylesheet, css::MediaQuery::Context const &ctx) {
-    auto tree_root = std::make_unique<StyledNode>(root);
-    style_tree_impl(*tree_root, stylesheet, ctx);
-    return tree_root;
+std::unique_ptr<StyledNode> style_tree_parallel(dom::Node const &root,
+        RuleSet const &rule_set,
+        InlineStyleCache &inline_styles,
+        css::MediaQuery::Context const &ctx,
+        std::size_t max_threads) {
+    if (max_threads <= 1) {
+        return style_tree(root, rule_set, inline_styles, ctx);
+    }
+
+    ParallelStyling parallel{root, max_threads};
+    return style_tree_impl(root, rule_set, inline_styles, ctx, &parallel);
 }
 
 } // namespace style
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -9,11 +9,18 @@
 #include "css/property_id.h"
 #include "css/style_sheet.h"
 #include "dom/dom.h"
+#include "dom/mutation_log.h"
+#include "style/inline_style_cache.h"
+#include "style/rule_set.h"
 #include "style/styled_node.h"
 
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,6 +38,46 @@ MatchingProperties matching_properties(StyledNode const &, css::StyleSheet const
 std::unique_ptr<StyledNode> style_tree(
         dom::Node const &root, css::StyleSheet const &, css::MediaQuery::Context const & = {});
 
+// Prefer this when styling the same stylesheet more than once, e.g. on relayout.
+std::unique_ptr<StyledNode> style_tree(dom::Node const &root, RuleSet const &, css::MediaQuery::Context const & = {});
+std::unique_ptr<StyledNode> style_tree(
+        dom::Node const &root, RuleSet const &, InlineStyleCache &, css::MediaQuery::Context const & = {});
+
+// Styles large enough subtrees on their own threads. The result is identical
+// to the one from style_tree.
+std::unique_ptr<StyledNode> style_tree_parallel(dom::Node const &root,
+        RuleSet const &,
+        InlineStyleCache &,
+        css::MediaQuery::Context const & = {},
+        std::size_t max_threads = std::thread::hardware_concurrency());
+
+// The styled node of every element in a styled tree. This points into the
+// tree, so it has to be rebuilt whenever the tree is recreated.
+using StyledElements = std::unordered_map<dom::Element const *, StyledNode *>;
+void index_styled_elements(StyledNode &root, StyledElements &);
+
+// Updates a tree created by one of the style_tree functions w/ the same rule
+// set and media context after the attributes of some elements have changed.
+// Only elements affected by the changes get their selectors matched again,
+// and only the descendants of elements whose style changed are recomputed.
+// Nothing outside of the subtrees of the changed elements is looked at.
+// Returns the number of elements whose selectors were matched again. The
+// elements whose style changed are added to `restyled` if it's provided.
+std::size_t restyle(StyledElements const &,
+        RuleSet const &,
+        InlineStyleCache &,
+        std::span<dom::AttributeChange const>,
+        css::MediaQuery::Context const & = {},
+        std::vector<StyledNode const *> *restyled = nullptr);
+
+// Like the above, but has to visit every element to find the changed ones.
+std::size_t restyle(StyledNode &root,
+        RuleSet const &,
+        InlineStyleCache &,
+        std::span<dom::AttributeChange const>,
+        css::MediaQuery::Context const & = {},
+        std::vector<StyledNode const *> *restyled = nullptr);
+
 } // namespace style
 
 #endif
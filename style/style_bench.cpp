@@ -1,16 +1,26 @@
-// SPDX-FileCopyrightText: 2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2025-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #include "style/style.h"
 
+#include "style/ancestor_filter.h"
+#include "style/inline_style_cache.h"
+#include "style/rule_set.h"
 #include "style/styled_node.h"
 
+#include "css/property_id.h"
+#include "css/rule.h"
+#include "css/style_sheet.h"
 #include "dom/dom.h"
 #include "etest/etest2.h"
+#include "gfx/color.h"
 
 #include <nanobench.h>
 
+#include <format>
+#include <utility>
+#include <variant>
 #include <vector>
 
 namespace {
@@ -116,5 +126,90 @@ int main() {
         }
     });
 
+    s.add_test("style_tree: deep tree, descendant selectors", [](etest::IActions &a) {
+        ankerl::nanobench::Bench bench;
+        bench.title("style_tree: deep tree").relative(true);
+
+        // 32 nested divs w/ a span at the bottom, and a lot of descendant
+        // selectors where the ancestors they need aren't in the tree.
+        dom::Node dom = dom::Element{"span"};
+        for (int i = 31; i >= 0; --i) {
+            dom = dom::Element{"div", {{"class", std::format("level-{}", i)}}, {std::move(dom)}};
+        }
+
+        css::StyleSheet stylesheet;
+        for (int i = 0; i < 500; ++i) {
+            stylesheet.rules.push_back({
+                    .selectors{std::format(".missing-{} div span", i), std::format("nav.menu-{} > div", i)},
+                    .declarations{{css::PropertyId::Color, "red"}},
+            });
+        }
+        stylesheet.rules.push_back({.selectors{".level-0 span"}, .declarations{{css::PropertyId::Color, "blue"}}});
+
+        style::RuleSet const rule_set{stylesheet};
+        auto styled = style::style_tree(dom, rule_set);
+        auto const *deepest = styled.get();
+        while (!deepest->children.empty()) {
+            deepest = &deepest->children.back();
+        }
+        a.expect_eq(deepest->get_property<css::PropertyId::Color>(), gfx::Color::from_css_name("blue"));
+
+        auto const active = rule_set.active_rules({});
+        bench.run("matching_rules, deepest, no ancestor filter", [&] {
+            ankerl::nanobench::doNotOptimizeAway(rule_set.matching_rules(*deepest, active));
+        });
+
+        style::AncestorFilter ancestors;
+        for (auto const *node = deepest->parent; node != nullptr; node = node->parent) {
+            ancestors.push(std::get<dom::Element>(node->node));
+        }
+
+        bench.run("matching_rules, deepest, ancestor filter", [&] {
+            ankerl::nanobench::doNotOptimizeAway(rule_set.matching_rules(*deepest, active, &ancestors));
+        });
+
+        bench.run("style_tree", [&] {
+            ankerl::nanobench::doNotOptimizeAway(style::style_tree(dom, rule_set)); //
+        });
+    });
+
+    s.add_test("style_tree: long table", [](etest::IActions &a) {
+        ankerl::nanobench::Bench bench;
+        bench.title("style_tree: long table");
+
+        // 2000 identical rows, which is what sibling style sharing is for.
+        dom::Element table{"table"};
+        for (int i = 0; i < 2000; ++i) {
+            dom::Element row{"tr", {{"class", "row"}}};
+            for (int j = 0; j < 4; ++j) {
+                row.children.emplace_back(dom::Element{"td", {{"class", "cell"}}, {dom::Text{"hello"}}});
+            }
+            table.children.emplace_back(std::move(row));
+        }
+
+        css::StyleSheet stylesheet;
+        for (int i = 0; i < 200; ++i) {
+            stylesheet.rules.push_back({
+                    .selectors{std::format(".unused-{} td", i)},
+                    .declarations{{css::PropertyId::Color, "red"}},
+            });
+        }
+        stylesheet.rules.push_back({.selectors{"table .row .cell"}, .declarations{{css::PropertyId::Color, "blue"}}});
+
+        style::RuleSet const rule_set{stylesheet};
+        auto styled = style::style_tree(table, rule_set);
+        a.expect_eq(styled->children.back().children.back().get_property<css::PropertyId::Color>(),
+                gfx::Color::from_css_name("blue"));
+
+        bench.run("style_tree", [&] {
+            ankerl::nanobench::doNotOptimizeAway(style::style_tree(table, rule_set)); //
+        });
+
+        style::InlineStyleCache inline_styles;
+        bench.run("style_tree_parallel", [&] {
+            ankerl::nanobench::doNotOptimizeAway(style::style_tree_parallel(table, rule_set, inline_styles));
+        });
+    });
+
     return s.run();
 }
@@ -1,8 +1,11 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #include "style/style.h"
+
+#include "style/inline_style_cache.h"
+#include "style/rule_set.h"
 #include "style/styled_node.h"
 
 #include "css/media_query.h"
@@ -10,10 +13,12 @@
 #include "css/rule.h"
 #include "css/style_sheet.h"
 #include "dom/dom.h"
+#include "dom/mutation_log.h"
 #include "etest/etest2.h"
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <format>
 #include <string>
 #include <string_view>
@@ -332,6 +337,168 @@ int main() {
         a.expect(check_parents(*style::style_tree(root, stylesheet), expected));
     });
 
+    s.add_test("style_tree: similar siblings", [](etest::IActions &a) {
+        dom::Element list{"ul"};
+        list.children.emplace_back(dom::Element{"li", {{"class", "a"}}});
+        list.children.emplace_back(dom::Element{"li", {{"class", "a"}}});
+        list.children.emplace_back(dom::Element{"li", {{"class", "b"}}});
+        list.children.emplace_back(dom::Element{"li", {{"class", "a"}, {"id", "c"}}});
+        list.children.emplace_back(dom::Element{"li", {{"class", "a"}, {"style", "width: 1px"}}});
+        list.children.emplace_back(dom::Element{"p", {{"class", "a"}}});
+        list.children.emplace_back(dom::Element{"li", {{"class", "a"}}});
+
+        css::StyleSheet stylesheet{{
+                {.selectors = {"ul .a"}, .declarations = {{css::PropertyId::Height, "1px"}}},
+                {.selectors = {"li.b", "#c"}, .declarations = {{css::PropertyId::Height, "2px"}}},
+                {.selectors = {"p"}, .declarations = {{css::PropertyId::Color, "red"}}},
+        }};
+
+        auto styled = style::style_tree(list, stylesheet);
+        auto height = [&](std::size_t i) { return styled->children.at(i).get_raw_property(css::PropertyId::Height); };
+        a.expect_eq(height(0), "1px");
+        a.expect_eq(height(1), "1px");
+        a.expect_eq(height(2), "2px");
+        a.expect_eq(height(3), "2px");
+        a.expect_eq(height(4), "1px");
+        a.expect_eq(styled->children.at(4).get_raw_property(css::PropertyId::Width), "1px");
+        a.expect_eq(styled->children.at(5).get_raw_property(css::PropertyId::Color), "red");
+        a.expect_eq(height(6), "1px");
+        a.expect_eq(styled->children.at(6).get_raw_property(css::PropertyId::Color), "canvastext");
+        a.expect(styled->children.at(6).computed.shares_groups_with(styled->children.at(0).computed));
+    });
+
+    s.add_test("style_tree_parallel: same result as style_tree", [](etest::IActions &a) {
+        // A few large subtrees, and a long list that has to be split up.
+        dom::Element body{"body"};
+        for (int i = 0; i < 4; ++i) {
+            dom::Element section{"section", {{"class", std::format("s{}", i)}}};
+            for (int j = 0; j < 300; ++j) {
+                section.children.emplace_back(dom::Element{
+                        "p", {{"class", std::format("p{}", j % 7)}}, {dom::Text{"hello"}, dom::Element{"span"}}});
+            }
+            body.children.emplace_back(std::move(section));
+        }
+        for (int i = 0; i < 3000; ++i) {
+            body.children.emplace_back(dom::Element{"div", {{"id", std::format("d{}", i)}}});
+        }
+        dom::Node const root = dom::Element{"html", {}, {std::move(body)}};
+
+        css::StyleSheet stylesheet{{
+                {.selectors = {".s1 p"}, .declarations = {{css::PropertyId::Height, "1px"}}},
+                {.selectors = {".s2 > .p3 span"}, .declarations = {{css::PropertyId::Color, "red"}}},
+                {.selectors = {"#d2999", "body > div"}, .declarations = {{css::PropertyId::Width, "2px"}}},
+                {.selectors = {"span"}, .declarations = {{css::PropertyId::FontSize, "2em"}}},
+        }};
+        style::RuleSet const rule_set{stylesheet};
+
+        style::InlineStyleCache inline_styles;
+        auto expected = style::style_tree(root, rule_set, inline_styles);
+        for (std::size_t threads : {1, 2, 3, 16}) {
+            auto styled = style::style_tree_parallel(root, rule_set, inline_styles, {}, threads);
+            a.expect(*styled == *expected);
+            a.expect(check_parents(*styled, *expected));
+        }
+    });
+
+    s.add_test("restyle", [](etest::IActions &a) {
+        dom::Element list{"ul", {{"class", "list"}}};
+        for (int i = 0; i < 10; ++i) {
+            list.children.emplace_back(dom::Element{"li", {}, {dom::Element{"span"}, dom::Text{"hi"}}});
+        }
+        dom::Node root = dom::Element{"body", {}, {std::move(list)}};
+
+        css::StyleSheet stylesheet{{
+                {.selectors = {".selected"}, .declarations = {{css::PropertyId::Color, "red"}}},
+                {.selectors = {".dark span"}, .declarations = {{css::PropertyId::BackgroundColor, "black"}}},
+                {.selectors = {"[hidden]"}, .declarations = {{css::PropertyId::Display, "none"}}},
+        }};
+        style::RuleSet const rule_set{stylesheet};
+        style::InlineStyleCache inline_styles;
+        auto styled = style::style_tree(root, rule_set, inline_styles);
+        style::StyledElements elements;
+        style::index_styled_elements(*styled, elements);
+
+        auto &body = std::get<dom::Element>(root);
+        auto &ul = std::get<dom::Element>(body.children[0]);
+        auto &third = std::get<dom::Element>(ul.children[2]);
+
+        dom::MutationLog log;
+        std::vector<style::StyledNode const *> restyled;
+        auto restyle = [&] {
+            restyled.clear();
+            auto rematched = style::restyle(elements, rule_set, inline_styles, log.attribute_changes(), {}, &restyled);
+            log.clear();
+            a.expect(*styled == *style::style_tree(root, rule_set, inline_styles));
+            return rematched;
+        };
+
+        // Nothing cares about titles.
+        log.set_attribute(third, "title", "hello");
+        a.expect_eq(restyle(), std::size_t{0});
+        a.expect(restyled.empty());
+
+        // Only the li itself is affected, and the span inherits the new color.
+        log.set_attribute(third, "class", "selected");
+        a.expect_eq(restyle(), std::size_t{1});
+        auto const &third_span = styled->children[0].children[2].children[0];
+        a.expect_eq(third_span.get_raw_property(css::PropertyId::Color), "red");
+        a.expect(restyled == std::vector<style::StyledNode const *>{&styled->children[0].children[2], &third_span});
+
+        // Everything below the ul has to be matched again, but not the ul itself.
+        log.set_attribute(ul, "class", "list dark");
+        a.expect_eq(restyle(), std::size_t{20});
+        a.expect_eq(third_span.get_raw_property(css::PropertyId::BackgroundColor), "black");
+
+        log.set_attribute(third, "style", "color: blue");
+        log.set_attribute(third, "hidden", "");
+        a.expect_eq(restyle(), std::size_t{1});
+        a.expect_eq(third_span.get_raw_property(css::PropertyId::Color), "blue");
+        a.expect_eq(styled->children[0].children[2].get_raw_property(css::PropertyId::Display), "none");
+
+        log.remove_attribute(third, "class");
+        log.remove_attribute(third, "style");
+        log.remove_attribute(ul, "class");
+        a.expect_eq(restyle(), std::size_t{20});
+        a.expect_eq(third_span.get_raw_property(css::PropertyId::Color), "canvastext");
+
+        // The li is matched again along w/ the rest of the ul's subtree, not twice.
+        log.set_attribute(third, "class", "selected");
+        log.set_attribute(ul, "class", "dark");
+        a.expect_eq(restyle(), std::size_t{20});
+        a.expect_eq(third_span.get_raw_property(css::PropertyId::Color), "red");
+
+        // Having the tree as the root works too, but has to look through all of it.
+        log.remove_attribute(ul, "class");
+        auto const rematched = style::restyle(*styled, rule_set, inline_styles, log.attribute_changes());
+        log.clear();
+        a.expect_eq(rematched, std::size_t{20});
+        a.expect(*styled == *style::style_tree(root, rule_set, inline_styles));
+    });
+
+    s.add_test("restyle, only the invalidated subtrees", [](etest::IActions &a) {
+        dom::Node root = dom::Element{"body", {}, {dom::Element{"p"}, dom::Element{"div", {}, {dom::Element{"a"}}}}};
+        css::StyleSheet stylesheet{{
+                {.selectors = {".big a"}, .declarations = {{css::PropertyId::FontSize, "30px"}}},
+        }};
+        style::RuleSet const rule_set{stylesheet};
+        style::InlineStyleCache inline_styles;
+        auto styled = style::style_tree(root, rule_set, inline_styles);
+
+        // Only the div is indexed, so restyling can't depend on finding
+        // anything outside of its subtree.
+        auto &div = std::get<dom::Element>(std::get<dom::Element>(root).children[1]);
+        style::StyledElements elements{{&div, &styled->children[1]}};
+
+        // Only the a is matched again, as the class doesn't affect the div itself.
+        dom::MutationLog log;
+        log.set_attribute(div, "class", "big");
+        std::vector<style::StyledNode const *> restyled;
+        a.expect_eq(style::restyle(elements, rule_set, inline_styles, log.attribute_changes(), {}, &restyled),
+                std::size_t{1});
+        a.expect(restyled == std::vector<style::StyledNode const *>{&styled->children[1].children[0]});
+        a.expect(*styled == *style::style_tree(root, rule_set, inline_styles));
+    });
+
     s.add_test("matching rules: custom properties", [](etest::IActions &a) {
         css::StyleSheet stylesheet{{
                 css::Rule{.selectors{"p"}, .custom_properties{{"--hello", "very yes"}}},
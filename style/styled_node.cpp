@@ -4,10 +4,12 @@
 
 #include "style/styled_node.h"
 
+#include "style/computed_style.h"
 #include "style/unresolved_value.h"
 
 #include "css/property_id.h"
 #include "dom/dom.h"
+#include "geom/layout_unit.h"
 #include "gfx/color.h"
 #include "util/string.h"
 
@@ -17,10 +19,12 @@
 #include <array>
 #include <charconv>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
 #include <optional>
+#include <ranges>
 #include <set>
 #include <sstream>
 #include <string>
@@ -37,12 +41,14 @@ bool is_var(std::string_view value) {
     return value.starts_with("var(") && value.ends_with(')');
 }
 
+// NOLINTNEXTLINE(misc-no-recursion)
 int get_root_font_size(style::StyledNode const &node) {
     auto const *n = &node;
-    while (n->parent != nullptr) {
+    while (n->computed.empty() && n->parent != nullptr) {
         n = n->parent;
     }
-    return n->get_property<css::PropertyId::FontSize>();
+
+    return n->computed.empty() ? n->get_property<css::PropertyId::FontSize>() : n->computed.root_font_size();
 }
 
 std::optional<gfx::Color> try_from_hex_chars(std::string_view hex_chars) {
@@ -221,37 +227,208 @@ int UnresolvedBorderWidth::resolve(
     return width.resolve(font_size, context, percent_relative_to);
 }
 
-int UnresolvedLineHeight::resolve(int font_size, ResolutionInfo context, std::optional<int> percent_relative_to) const {
+geom::LayoutUnit UnresolvedLineHeight::resolve(
+        int font_size, ResolutionInfo context, std::optional<geom::LayoutUnit> percent_relative_to) const {
     if (line_height.raw == "normal") {
-        return static_cast<int>(font_size * 1.2f);
+        return geom::LayoutUnit::from_float(static_cast<float>(font_size) * 1.2f);
     }
 
     float maybe_line_height{};
     auto res =
             std::from_chars(line_height.raw.data(), line_height.raw.data() + line_height.raw.size(), maybe_line_height);
     if (res.ec == std::errc{} && line_height.raw.data() + line_height.raw.size() == res.ptr) {
-        return static_cast<int>(font_size * maybe_line_height);
+        return geom::LayoutUnit::from_float(static_cast<float>(font_size) * maybe_line_height);
     }
 
-    return line_height.try_resolve(font_size, context, percent_relative_to)
-            .value_or(static_cast<int>(1.2f * font_size));
+    return line_height.try_resolve_subpixel(font_size, context, percent_relative_to)
+            .value_or(geom::LayoutUnit::from_float(1.2f * static_cast<float>(font_size)));
 }
 
 // NOLINTNEXTLINE(misc-no-recursion)
 std::string_view StyledNode::get_raw_property(css::PropertyId property) const {
-    // We don't support selector specificity yet, so the last property is found
-    // in order to allow website style to override the browser built-in style.
+    if (!computed.empty()) {
+        return computed.get(property);
+    }
+
+    // The properties are in cascade order, so the last one wins.
     auto it = std::ranges::find_if(
             rbegin(properties), rend(properties), [=](auto const &p) { return p.first == property; });
+    if (it == rend(properties)) {
+        return resolve_undeclared_property(property);
+    }
+
+    return resolve_declared_property(property, it->second);
+}
+
+void StyledNode::compute_properties(ComputedStyle::Cache *cache) {
+    computed = {};
+
+    auto base = [&] {
+        if (parent == nullptr || parent->computed.empty()) {
+            return ComputedStyle::initial();
+        }
+
+        // See resolve_undeclared_property.
+        if (std::holds_alternative<dom::Text>(node)) {
+            return parent->computed;
+        }
+
+        return ComputedStyle::inheriting_from(parent->computed);
+    }();
+
+    // Declaring only what's inherited anyway, e.g. when the same rule matches
+    // an element and its parent, keeps sharing the parent's properties.
+    auto const redeclares_inherited = [&] {
+        if (parent != nullptr && parent->computed.empty()) {
+            return false;
+        }
+
+        return std::ranges::all_of(custom_properties, [&](auto const &p) {
+            return !is_var(p.second) && base.get_custom(p.first) == p.second;
+        });
+    };
 
+    ComputedStyle::Builder builder{base};
+    if (!custom_properties.empty() && !redeclares_inherited()) {
+        builder.set_custom_properties(resolve_custom_properties(base.custom_properties()));
+    }
+
+    if (parent != nullptr && parent->computed.empty()) {
+        for (std::size_t i = 0; i < css::kPropertyIdCount; ++i) {
+            auto const property = static_cast<css::PropertyId>(i);
+            if (is_inherited(property) || std::holds_alternative<dom::Text>(node)) {
+                builder.set(property, parent->get_raw_property(property));
+            }
+        }
+    }
+
+    std::array<std::string const *, css::kPropertyIdCount> declared{};
+    for (auto const &[property, value] : properties) {
+        declared[static_cast<std::size_t>(property)] = &value;
+    }
+
+    for (std::size_t i = 0; i < declared.size(); ++i) {
+        if (declared[i] != nullptr) {
+            auto const property = static_cast<css::PropertyId>(i);
+            builder.set(property, resolve_declared_property(property, *declared[i]));
+        }
+    }
+
+    // Resolved before `computed` is set so that the font sizes are computed
+    // from the declarations, reusing the ones cached on the ancestors.
+    auto const font_size = get_font_size_property();
+    builder.set_font_sizes(font_size, parent != nullptr ? get_root_font_size(*parent) : font_size);
+    computed = std::move(builder).build(cache);
+}
+
+ComputedStyle::CustomProperties StyledNode::resolve_custom_properties(
+        ComputedStyle::CustomProperties const &inherited) const {
+    auto resolved = inherited;
+    if (parent != nullptr && parent->computed.empty()) {
+        for (auto const *current = parent; current != nullptr; current = current->parent) {
+            if (!current->computed.empty()) {
+                for (auto const &[name, value] : current->computed.custom_properties()) {
+                    resolved.try_emplace(name, value);
+                }
+                break;
+            }
+
+            // Closest first, and the last declaration wins.
+            for (auto const &[name, value] : std::views::reverse(current->custom_properties)) {
+                resolved.try_emplace(name, value);
+            }
+        }
+    }
+
+    for (auto const &[name, value] : custom_properties) {
+        resolved.insert_or_assign(name, value);
+    }
+
+    // Every var() is resolved against the values declared on this node, so
+    // resolve them all before writing anything back. References that end up
+    // in a cycle make the custom property invalid.
+    // https://drafts.csswg.org/css-variables/#cycles
+    std::vector<std::pair<std::string_view, std::optional<std::string>>> substitutions;
+    for (auto const &[name, unused] : custom_properties) {
+        std::optional<std::string_view> current = resolved.find(name)->second;
+        if (!is_var(*current)) {
+            continue;
+        }
+
+        std::set<std::string_view> seen{name};
+        while (current.has_value() && is_var(*current)) {
+            auto [var_name, fallback] = util::split_once(current->substr(4, current->size() - 5), ',');
+            var_name = util::trim(var_name);
+            if (!seen.insert(var_name).second) {
+                spdlog::warn("Circular variable reference '{}'", name);
+                current.reset();
+            } else if (auto it = resolved.find(var_name); it != resolved.end()) {
+                current = it->second;
+            } else if (fallback = util::trim(fallback); !fallback.empty()) {
+                current = fallback;
+            } else {
+                current.reset();
+            }
+        }
+
+        substitutions.emplace_back(name, current.transform([](auto v) { return std::string{v}; }));
+    }
+
+    for (auto &[name, value] : substitutions) {
+        auto it = resolved.find(name);
+        if (it == resolved.end()) {
+            // Declared more than once and already dropped.
+            continue;
+        }
+
+        if (value.has_value()) {
+            it->second = *std::move(value);
+        } else {
+            resolved.erase(it);
+        }
+    }
+
+    return resolved;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::optional<std::string_view> StyledNode::find_custom_property(std::string_view name) const {
+    for (auto const *current = this; current != nullptr; current = current->parent) {
+        // Computed nodes have everything they inherit resolved already.
+        if (!current->computed.empty()) {
+            return current->computed.get_custom(name);
+        }
+
+        // The last declaration wins.
+        auto const declared = std::views::reverse(current->custom_properties);
+        auto p = std::ranges::find(declared, name, &std::pair<std::string, std::string>::first);
+        if (p != end(declared)) {
+            return p->second;
+        }
+    }
+
+    return std::nullopt;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::string_view StyledNode::resolve_undeclared_property(css::PropertyId property) const {
     // TODO(robinlinden): Having a special case for dom::Text here doesn't feel good.
     // You can't set properties on text nodes in HTML (even though we do in
     // tests), so let's grab this from the parent node.
-    if (it == rend(properties) && std::holds_alternative<dom::Text>(node) && parent != nullptr) {
+    if (std::holds_alternative<dom::Text>(node) && parent != nullptr) {
         return parent->get_raw_property(property);
     }
 
-    if (it == rend(properties) || it->second == "unset") {
+    if (is_inherited(property) && parent != nullptr) {
+        return parent->get_raw_property(property);
+    }
+
+    return css::initial_value(property);
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
+std::string_view StyledNode::resolve_declared_property(css::PropertyId property, std::string_view value) const {
+    if (value == "unset") {
         // https://developer.mozilla.org/en-US/docs/Web/CSS/unset
         if (is_inherited(property) && parent != nullptr) {
             return parent->get_raw_property(property);
@@ -260,20 +437,20 @@ std::string_view StyledNode::get_raw_property(css::PropertyId property) const {
         return css::initial_value(property);
     }
 
-    if (it->second == "initial") {
+    if (value == "initial") {
         // https://developer.mozilla.org/en-US/docs/Web/CSS/initial
         return css::initial_value(property);
     }
 
-    if (it->second == "inherit") {
+    if (value == "inherit") {
         // https://developer.mozilla.org/en-US/docs/Web/CSS/inherit
         return get_parent_raw_property(*this, property);
     }
 
-    if (it->second == "currentcolor") {
+    if (value == "currentcolor") {
         // https://developer.mozilla.org/en-US/docs/Web/CSS/color_value#currentcolor_keyword
         // If the "color" property has the value "currentcolor", treat it as "inherit".
-        if (it->first == css::PropertyId::Color) {
+        if (property == css::PropertyId::Color) {
             return get_parent_raw_property(*this, property);
         }
 
@@ -284,11 +461,11 @@ std::string_view StyledNode::get_raw_property(css::PropertyId property) const {
         return get_raw_property(css::PropertyId::Color);
     }
 
-    if (is_var(it->second)) {
-        return resolve_variable(it->second).value_or(css::initial_value(property));
+    if (is_var(value)) {
+        return resolve_variable(value).value_or(css::initial_value(property));
     }
 
-    return it->second;
+    return value;
 }
 
 std::optional<std::string_view> StyledNode::resolve_variable(std::string_view value) const {
@@ -298,17 +475,7 @@ std::optional<std::string_view> StyledNode::resolve_variable(std::string_view va
         auto var = value.substr(4, value.size() - 5);
         auto [var_name, fallback] = util::split_once(var, ',');
 
-        std::optional<std::string_view> prop;
-        for (auto const *current = this; current != nullptr; current = current->parent) {
-            auto p = std::ranges::find(
-                    current->custom_properties, var_name, &std::pair<std::string, std::string>::first);
-            if (p == end(current->custom_properties)) {
-                continue;
-            }
-
-            prop = p->second;
-            break;
-        }
+        auto prop = find_custom_property(var_name);
 
         if (!prop) {
             fallback = util::trim(fallback);
@@ -582,21 +749,25 @@ constexpr auto kFontSizeAbsoluteSizeKeywords = std::to_array<std::pair<std::stri
 
 // NOLINTNEXTLINE(misc-no-recursion)
 int StyledNode::get_font_size_property() const {
-    auto get_closest_font_size_and_owner =
-            [](StyledNode const *starting_node) -> std::optional<std::pair<std::string_view, StyledNode const *>> {
-        for (auto const *n = starting_node; n != nullptr; n = n->parent) {
-            auto it = std::ranges::find_if(rbegin(n->properties), rend(n->properties), [](auto const &v) {
-                return v.first == css::PropertyId::FontSize;
-            });
-            if (it != rend(n->properties) && it->second != "inherit" && it->second != "unset") {
-                return {{it->second, n}};
-            }
+    if (!computed.empty()) {
+        return computed.font_size();
+    }
+
+    std::optional<std::pair<std::string_view, StyledNode const *>> closest;
+    for (auto const *n = this; n != nullptr && !closest; n = n->parent) {
+        // Everything below this node inherits its font size.
+        if (!n->computed.empty()) {
+            return n->computed.font_size();
         }
 
-        return std::nullopt;
-    };
+        auto it = std::ranges::find_if(rbegin(n->properties), rend(n->properties), [](auto const &v) {
+            return v.first == css::PropertyId::FontSize;
+        });
+        if (it != rend(n->properties) && it->second != "inherit" && it->second != "unset") {
+            closest = {it->second, n};
+        }
+    }
 
-    auto closest = get_closest_font_size_and_owner(this);
     if (!closest) {
         return kDefaultFontSize;
     }
@@ -665,14 +836,9 @@ int StyledNode::get_font_size_property() const {
     }
 
     if (unit == "rem") {
-        auto const *root = [&] {
-            auto const *n = closest->second;
-            while (n->parent != nullptr) {
-                n = n->parent;
-            }
-            return n;
-        }();
-        auto root_font_size = (root != nullptr) && root != this ? root->get_font_size_property() : kDefaultFontSize;
+        // rem on the root element is relative to the initial font size.
+        auto const *owner = closest->second;
+        auto root_font_size = owner->parent != nullptr ? get_root_font_size(*owner->parent) : kDefaultFontSize;
         return kClamp(value * root_font_size);
     }
 
@@ -1,14 +1,16 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #ifndef STYLE_STYLED_NODE_H_
 #define STYLE_STYLED_NODE_H_
 
+#include "style/computed_style.h"
 #include "style/unresolved_value.h"
 
 #include "css/property_id.h"
 #include "dom/dom.h"
+#include "geom/layout_unit.h"
 #include "gfx/color.h"
 #include "util/string.h"
 
@@ -121,8 +123,8 @@ struct UnresolvedLineHeight {
     UnresolvedValue line_height{};
     [[nodiscard]] bool operator==(UnresolvedLineHeight const &) const = default;
 
-    [[nodiscard]] int resolve(
-            int font_size, ResolutionInfo, std::optional<int> percent_relative_to = std::nullopt) const;
+    [[nodiscard]] geom::LayoutUnit resolve(
+            int font_size, ResolutionInfo, std::optional<geom::LayoutUnit> percent_relative_to = std::nullopt) const;
 };
 
 // NOLINTNEXTLINE(misc-no-recursion)
@@ -132,9 +134,18 @@ struct StyledNode {
     std::vector<StyledNode> children;
     StyledNode const *parent{nullptr};
     std::vector<std::pair<std::string, std::string>> custom_properties;
+    // Filled in by compute_properties(). Until then, property lookups look
+    // through `properties` and up the tree every time.
+    ComputedStyle computed{};
 
     std::string_view get_raw_property(css::PropertyId) const;
 
+    // Resolves all properties up front so that get_raw_property is a table
+    // lookup. This should be done top-down so that the inherited properties
+    // can be shared w/ the parent. Passing in a cache lets nodes w/o the same
+    // parent share their computed properties as well.
+    void compute_properties(ComputedStyle::Cache * = nullptr);
+
     template<css::PropertyId T>
     auto get_property() const {
         if constexpr (T == css::PropertyId::BackgroundColor || T == css::PropertyId::BorderBottomColor
@@ -195,7 +206,11 @@ struct StyledNode {
     }
 
 private:
+    std::string_view resolve_declared_property(css::PropertyId, std::string_view value) const;
+    std::string_view resolve_undeclared_property(css::PropertyId) const;
     std::optional<std::string_view> resolve_variable(std::string_view) const;
+    std::optional<std::string_view> find_custom_property(std::string_view name) const;
+    ComputedStyle::CustomProperties resolve_custom_properties(ComputedStyle::CustomProperties const &inherited) const;
 
     BorderStyle get_border_style_property(css::PropertyId) const;
     gfx::Color get_color_property(css::PropertyId) const;
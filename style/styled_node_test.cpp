@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2021-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2021-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -10,8 +10,10 @@
 #include "dom/dom.h"
 #include "dom/xpath.h"
 #include "etest/etest2.h"
+#include "geom/layout_unit.h"
 #include "gfx/color.h"
 
+#include <cstddef>
 #include <optional>
 #include <source_location>
 #include <string>
@@ -677,9 +679,214 @@ int main() {
         expect_property_eq<css::PropertyId::LineHeight>(a, "normal", style::UnresolvedLineHeight{"normal"});
         expect_property_eq<css::PropertyId::LineHeight>(a, "1.5", style::UnresolvedLineHeight{"1.5"});
 
-        a.expect_eq(style::UnresolvedLineHeight{"30px"}.resolve(0, {}), 30.f);
-        a.expect_eq(style::UnresolvedLineHeight{"1.5"}.resolve(10, {}), 15.f);
-        a.expect_eq(style::UnresolvedLineHeight{"normal"}.resolve(10, {}), 12.f);
+        a.expect_eq(style::UnresolvedLineHeight{"30px"}.resolve(0, {}), geom::LayoutUnit{30});
+        a.expect_eq(style::UnresolvedLineHeight{"1.5"}.resolve(10, {}), geom::LayoutUnit{15});
+        a.expect_eq(style::UnresolvedLineHeight{"normal"}.resolve(10, {}), geom::LayoutUnit{12});
+        // Fractions of pixels are kept.
+        a.expect_eq(style::UnresolvedLineHeight{"normal"}.resolve(16, {}), geom::LayoutUnit::from_float(19.2f));
+        a.expect_eq(style::UnresolvedLineHeight{"1.25em"}.resolve(10, {}), geom::LayoutUnit::from_float(12.5f));
+    });
+
+    s.add_test("compute_properties", [](etest::IActions &a) {
+        dom::Node dom_node = dom::Element{"dummy"s};
+        dom::Node text_node = dom::Text{"hi"s};
+        style::StyledNode root{
+                .node = dom_node,
+                .properties = {{css::PropertyId::Color, "red"}, {css::PropertyId::Width, "10px"}},
+                .children = {
+                        {dom_node,
+                                {{css::PropertyId::BackgroundColor, "currentcolor"},
+                                        {css::PropertyId::Height, "var(--h)"},
+                                        {css::PropertyId::Color, "blue"},
+                                        {css::PropertyId::FontStyle, "inherit"}},
+                                {}},
+                        {text_node},
+                },
+                .custom_properties = {{"--h", "5px"}},
+        };
+        for (auto &child : root.children) {
+            child.parent = &root;
+        }
+
+        std::vector<std::string_view> uncomputed;
+        for (auto const *node : {&root, &root.children[0], &root.children[1]}) {
+            for (std::size_t i = 0; i < css::kPropertyIdCount; ++i) {
+                uncomputed.push_back(node->get_raw_property(static_cast<css::PropertyId>(i)));
+            }
+        }
+
+        root.compute_properties();
+        root.children[0].compute_properties();
+        a.expect(!root.computed.empty());
+        a.expect(!root.children[0].computed.empty());
+
+        std::vector<std::string_view> computed;
+        for (auto const *node : {&root, &root.children[0], &root.children[1]}) {
+            for (std::size_t i = 0; i < css::kPropertyIdCount; ++i) {
+                computed.push_back(node->get_raw_property(static_cast<css::PropertyId>(i)));
+            }
+        }
+
+        a.expect_eq(computed, uncomputed);
+        a.expect_eq(root.children[0].get_raw_property(css::PropertyId::BackgroundColor), "blue");
+        a.expect_eq(root.children[0].get_raw_property(css::PropertyId::Height), "5px");
+        a.expect_eq(root.children[0].get_raw_property(css::PropertyId::Width), "auto");
+        a.expect_eq(root.children[1].get_raw_property(css::PropertyId::Width), "10px");
+
+        // The text node doesn't declare anything, so it's able to share everything w/ its parent.
+        root.children[1].compute_properties();
+        a.expect(root.children[1].computed.shares_groups_with(root.computed));
+        a.expect_eq(root.children[1].get_raw_property(css::PropertyId::Width), "10px");
+    });
+
+    s.add_test("compute_properties: siblings share styles", [](etest::IActions &a) {
+        dom::Node dom_node = dom::Element{"dummy"s};
+        style::StyledNode root{
+                .node = dom_node,
+                .properties = {{css::PropertyId::Color, "red"}},
+                .children = {
+                        {dom_node, {{css::PropertyId::Display, "block"}}},
+                        {dom_node, {{css::PropertyId::Display, "block"}}},
+                        {dom_node, {{css::PropertyId::Color, "red"}}},
+                },
+        };
+
+        style::ComputedStyle::Cache cache;
+        root.compute_properties(&cache);
+        for (auto &child : root.children) {
+            child.parent = &root;
+            child.compute_properties(&cache);
+        }
+
+        a.expect(root.children[0].computed.shares_groups_with(root.children[1].computed));
+        // Setting something to the value it already has doesn't copy anything.
+        a.expect(root.children[2].computed.shares_groups_with(style::ComputedStyle::inheriting_from(root.computed)));
+        a.expect_eq(root.children[0].get_raw_property(css::PropertyId::Display), "block");
+        a.expect_eq(root.children[0].get_raw_property(css::PropertyId::Color), "red");
+    });
+
+    s.add_test("compute_properties: custom properties", [](etest::IActions &a) {
+        dom::Node dom_node = dom::Element{"dummy"s};
+        style::StyledNode root{
+                .node = dom_node,
+                .children = {
+                        {.node = dom_node,
+                                .properties = {{css::PropertyId::Color, "var(--b)"}},
+                                .custom_properties = {{"--a", "blue"}}},
+                        {.node = dom_node, .properties = {{css::PropertyId::Width, "var(--c, 3px)"}}},
+                },
+                .custom_properties = {
+                        {"--a", "red"},
+                        {"--b", "var(--a)"},
+                        {"--c", "var(--d)"},
+                        {"--d", "var(--c)"},
+                        {"--e", "var(--missing, var(--a))"},
+                },
+        };
+
+        root.compute_properties();
+        for (auto &child : root.children) {
+            child.parent = &root;
+            child.compute_properties();
+        }
+
+        auto const &custom = root.computed.custom_properties();
+        a.expect_eq(custom,
+                style::ComputedStyle::CustomProperties{
+                        {"--a", "red"},
+                        {"--b", "red"},
+                        {"--e", "red"},
+                });
+
+        // var() in custom properties is resolved where they're declared, not where they're used.
+        a.expect_eq(root.children[0].get_raw_property(css::PropertyId::Color), "red");
+        a.expect_eq(root.children[0].computed.get_custom("--a"), "blue");
+
+        // Custom properties in a cycle are invalid, and the inherited ones aren't copied.
+        a.expect_eq(root.children[1].get_raw_property(css::PropertyId::Width), "3px");
+        a.expect_eq(&root.children[1].computed.custom_properties(), &custom);
+    });
+
+    s.add_test("custom properties, last declaration wins", [](etest::IActions &a) {
+        dom::Node dom_node = dom::Element{"dummy"s};
+        style::StyledNode root{
+                .node = dom_node,
+                .children = {{.node = dom_node, .properties = {{css::PropertyId::Color, "var(--x)"}}}},
+                .custom_properties = {{"--x", "red"}, {"--x", "blue"}},
+        };
+        auto &child = root.children[0];
+        child.parent = &root;
+
+        // Both w/o and w/ the computed styles.
+        a.expect_eq(child.get_raw_property(css::PropertyId::Color), "blue");
+        root.compute_properties();
+        child.compute_properties();
+        a.expect_eq(root.computed.get_custom("--x"), "blue");
+        a.expect_eq(child.get_raw_property(css::PropertyId::Color), "blue");
+    });
+
+    s.add_test("compute_properties: custom properties are shared", [](etest::IActions &a) {
+        dom::Node dom_node = dom::Element{"dummy"s};
+        style::StyledNode root{
+                .node = dom_node,
+                .children = {
+                        {.node = dom_node, .custom_properties = {{"--a", "red"}}},
+                        {.node = dom_node, .custom_properties = {{"--b", "blue"}}},
+                        {.node = dom_node, .custom_properties = {{"--b", "blue"}}},
+                        {.node = dom_node, .custom_properties = {{"--a", "blue"}, {"--a", "red"}}},
+                },
+                .custom_properties = {{"--a", "red"}},
+        };
+
+        style::ComputedStyle::Cache cache;
+        root.compute_properties(&cache);
+        for (auto &child : root.children) {
+            child.parent = &root;
+            child.compute_properties(&cache);
+        }
+
+        // Redeclaring what's inherited doesn't copy anything.
+        auto const &custom = root.computed.custom_properties();
+        a.expect_eq(&root.children[0].computed.custom_properties(), &custom);
+
+        // Siblings declaring the same things share them.
+        a.expect_eq(&root.children[1].computed.custom_properties(), &root.children[2].computed.custom_properties());
+        a.expect_eq(root.children[1].computed.custom_properties(),
+                style::ComputedStyle::CustomProperties{{"--a", "red"}, {"--b", "blue"}});
+
+        a.expect_eq(root.children[3].computed.custom_properties(), custom);
+    });
+
+    s.add_test("compute_properties: font sizes", [](etest::IActions &a) {
+        dom::Node dom_node = dom::Element{"dummy"s};
+        style::StyledNode root{
+                .node = dom_node,
+                .properties = {{css::PropertyId::FontSize, "20px"}},
+                .children = {{
+                        .node = dom_node,
+                        .properties = {{css::PropertyId::FontSize, "2em"}},
+                        .children = {{.node = dom_node, .properties = {{css::PropertyId::FontSize, "1.5rem"}}}},
+                }},
+        };
+        auto &child = root.children[0];
+        auto &grandchild = child.children[0];
+        child.parent = &root;
+        grandchild.parent = &child;
+
+        auto uncomputed = grandchild.get_property<css::PropertyId::FontSize>();
+        root.compute_properties();
+        child.compute_properties();
+        grandchild.compute_properties();
+
+        a.expect_eq(root.computed.font_size(), 20);
+        a.expect_eq(child.computed.font_size(), 40);
+        a.expect_eq(grandchild.computed.font_size(), 30);
+        a.expect_eq(grandchild.computed.font_size(), uncomputed);
+        a.expect_eq(grandchild.computed.root_font_size(), 20);
+
+        // The cached sizes are used from now on.
+        root.properties = {{css::PropertyId::FontSize, "10px"}};
+        a.expect_eq(grandchild.get_property<css::PropertyId::FontSize>(), 30);
     });
 
     return s.run();
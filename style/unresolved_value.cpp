@@ -4,6 +4,8 @@
 
 #include "style/unresolved_value.h"
 
+#include "geom/layout_unit.h"
+
 #include <spdlog/spdlog.h>
 
 #include <charconv>
@@ -14,23 +16,13 @@
 #include <system_error>
 
 namespace style {
+namespace {
 
-int UnresolvedValue::resolve(int font_size,
-        ResolutionInfo context,
-        std::optional<int> percent_relative_to,
-        std::source_location const &caller) const {
-    return try_resolve(font_size, context, percent_relative_to, caller).value_or(0);
-}
-
-std::optional<int> UnresolvedValue::try_resolve(int font_size,
+std::optional<float> try_resolve_px(std::string_view raw,
+        int font_size,
         ResolutionInfo context,
-        std::optional<int> percent_relative_to,
-        std::source_location const &caller) const {
-    // Special case for 0 since it won't ever have a unit that needs to be handled.
-    if (raw == "0") {
-        return 0;
-    }
-
+        std::optional<float> percent_relative_to,
+        std::source_location const &caller) {
     float res{};
     auto parse_result = std::from_chars(raw.data(), raw.data() + raw.size(), res);
     if (parse_result.ec != std::errc{}) {
@@ -54,21 +46,19 @@ std::optional<int> UnresolvedValue::try_resolve(int font_size,
             return std::nullopt;
         }
 
-        return static_cast<int>(res / 100.f * (*percent_relative_to));
+        return res / 100.f * (*percent_relative_to);
     }
 
     if (unit == "px") {
-        return static_cast<int>(res);
+        return res;
     }
 
     if (unit == "em") {
-        res *= static_cast<float>(font_size);
-        return static_cast<int>(res);
+        return res * static_cast<float>(font_size);
     }
 
     if (unit == "rem") {
-        res *= static_cast<float>(context.root_font_size);
-        return static_cast<int>(res);
+        return res * static_cast<float>(context.root_font_size);
     }
 
     // https://www.w3.org/TR/css3-values/#ex
@@ -78,19 +68,17 @@ std::optional<int> UnresolvedValue::try_resolve(int font_size,
         // respectively, but we're allowed to approximate it as 50% of the em
         // value.
         static constexpr float kExToEmRatio = 0.5f;
-        return static_cast<int>(res * kExToEmRatio * font_size);
+        return res * kExToEmRatio * static_cast<float>(font_size);
     }
 
     // https://www.w3.org/TR/css3-values/#vw
     if (unit == "vw") {
-        res *= static_cast<float>(context.viewport_width) / 100;
-        return static_cast<int>(res);
+        return res * (static_cast<float>(context.viewport_width) / 100);
     }
 
     // https://www.w3.org/TR/css3-values/#vh
     if (unit == "vh") {
-        res *= static_cast<float>(context.viewport_height) / 100;
-        return static_cast<int>(res);
+        return res * (static_cast<float>(context.viewport_height) / 100);
     }
 
     spdlog::warn("{}({}:{}): Bad property '{}' w/ unit '{}' in to_px",
@@ -102,4 +90,47 @@ std::optional<int> UnresolvedValue::try_resolve(int font_size,
     return std::nullopt;
 }
 
+} // namespace
+
+int UnresolvedValue::resolve(int font_size,
+        ResolutionInfo context,
+        std::optional<int> percent_relative_to,
+        std::source_location const &caller) const {
+    return try_resolve(font_size, context, percent_relative_to, caller).value_or(0);
+}
+
+std::optional<int> UnresolvedValue::try_resolve(int font_size,
+        ResolutionInfo context,
+        std::optional<int> percent_relative_to,
+        std::source_location const &caller) const {
+    // Special case for 0 since it won't ever have a unit that needs to be handled.
+    if (raw == "0") {
+        return 0;
+    }
+
+    auto relative_to = percent_relative_to.transform([](int px) { return static_cast<float>(px); });
+    return try_resolve_px(raw, font_size, context, relative_to, caller).transform([](float px) {
+        return static_cast<int>(px);
+    });
+}
+
+geom::LayoutUnit UnresolvedValue::resolve_subpixel(int font_size,
+        ResolutionInfo context,
+        std::optional<geom::LayoutUnit> percent_relative_to,
+        std::source_location const &caller) const {
+    return try_resolve_subpixel(font_size, context, percent_relative_to, caller).value_or(geom::LayoutUnit{});
+}
+
+std::optional<geom::LayoutUnit> UnresolvedValue::try_resolve_subpixel(int font_size,
+        ResolutionInfo context,
+        std::optional<geom::LayoutUnit> percent_relative_to,
+        std::source_location const &caller) const {
+    if (raw == "0") {
+        return geom::LayoutUnit{};
+    }
+
+    auto relative_to = percent_relative_to.transform(&geom::LayoutUnit::to_float);
+    return try_resolve_px(raw, font_size, context, relative_to, caller).transform(&geom::LayoutUnit::from_float);
+}
+
 } // namespace style
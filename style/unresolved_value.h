@@ -1,10 +1,12 @@
-// SPDX-FileCopyrightText: 2023-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2023-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #ifndef STYLE_UNRESOLVED_VALUE_H_
 #define STYLE_UNRESOLVED_VALUE_H_
 
+#include "geom/layout_unit.h"
+
 #include <optional>
 #include <source_location>
 #include <string_view>
@@ -31,6 +33,17 @@ struct UnresolvedValue {
             ResolutionInfo,
             std::optional<int> percent_relative_to = std::nullopt,
             std::source_location const &caller = std::source_location::current()) const;
+
+    // Like the above, but rounded to the closest LayoutUnit instead of down
+    // to whole pixels.
+    geom::LayoutUnit resolve_subpixel(int font_size,
+            ResolutionInfo,
+            std::optional<geom::LayoutUnit> percent_relative_to = std::nullopt,
+            std::source_location const &caller = std::source_location::current()) const;
+    std::optional<geom::LayoutUnit> try_resolve_subpixel(int font_size,
+            ResolutionInfo,
+            std::optional<geom::LayoutUnit> percent_relative_to = std::nullopt,
+            std::source_location const &caller = std::source_location::current()) const;
 };
 
 } // namespace style
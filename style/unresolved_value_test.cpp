@@ -1,10 +1,11 @@
-// SPDX-FileCopyrightText: 2023-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2023-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #include "style/unresolved_value.h"
 
 #include "etest/etest2.h"
+#include "geom/layout_unit.h"
 
 #include <optional>
 
@@ -92,5 +93,21 @@ int main() {
         a.expect_eq(nonsense.try_resolve(100, {.root_font_size = 100}, 100), std::nullopt);
     });
 
+    s.add_test("resolve_subpixel", [](etest::IActions &a) {
+        auto const px = [](float f) { return geom::LayoutUnit::from_float(f); };
+        a.expect_eq(UnresolvedValue{.raw = "0"}.resolve_subpixel(10, {}), geom::LayoutUnit{});
+        a.expect_eq(UnresolvedValue{.raw = "1.5px"}.resolve_subpixel(10, {}), px(1.5f));
+        a.expect_eq(UnresolvedValue{.raw = "1.5px"}.resolve(10, {}), 1);
+        a.expect_eq(UnresolvedValue{.raw = "1.25em"}.resolve_subpixel(10, {}), px(12.5f));
+        a.expect_eq(UnresolvedValue{.raw = "1ex"}.resolve_subpixel(15, {}), px(7.5f));
+
+        // Percentages of fractions of pixels.
+        auto const percent = UnresolvedValue{.raw = "50%"};
+        a.expect_eq(percent.resolve_subpixel(10, {}, px(10.5f)), px(5.25f));
+        a.expect_eq(percent.try_resolve_subpixel(10, {}), std::nullopt);
+
+        a.expect_eq(UnresolvedValue{.raw = "foo"}.try_resolve_subpixel(10, {}, 10), std::nullopt);
+    });
+
     return s.run();
 }
@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2023-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2023-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -7,9 +7,11 @@
 
 #include "type/type.h"
 
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 namespace type {
 
@@ -18,6 +20,17 @@ public:
     Size measure(std::string_view text, Px font_size, Weight) const override {
         return Size{static_cast<int>(text.size()) * font_size.v / 2, font_size.v};
     }
+
+    std::vector<int> word_ends(std::string_view text, Px font_size, Weight) const override {
+        std::vector<int> ends;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == ' ') {
+                ends.push_back(static_cast<int>(i) * font_size.v / 2);
+            }
+        }
+        ends.push_back(static_cast<int>(text.size()) * font_size.v / 2);
+        return ends;
+    }
 };
 
 class NaiveType : public IType {
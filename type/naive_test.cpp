@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2023-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2023-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -8,6 +8,9 @@
 
 #include "etest/etest2.h"
 
+#include <string_view>
+#include <vector>
+
 int main() {
     etest::Suite s{"type/naive"};
 
@@ -23,6 +26,29 @@ int main() {
         a.expect_eq(font20px->measure("hello", type::Px{20}, type::Weight::Normal), type::Size{50, 20});
     });
 
+    s.add_test("NaiveFont::word_ends", [](etest::IActions &a) {
+        type::NaiveFont font;
+        a.expect_eq(font.word_ends("", type::Px{10}, type::Weight::Normal), std::vector{0});
+        a.expect_eq(font.word_ends("hello", type::Px{10}, type::Weight::Normal), std::vector{25});
+        a.expect_eq(font.word_ends("a bb  ccc", type::Px{10}, type::Weight::Normal), (std::vector{5, 20, 25, 45}));
+
+        // Same as measuring the text up to each space.
+        a.expect_eq(font.word_ends("a bb", type::Px{11}, type::Weight::Normal), (std::vector{5, 22}));
+    });
+
+    s.add_test("IFont::word_ends", [](etest::IActions &a) {
+        // Uses the default implementation.
+        struct Font : public type::IFont {
+            type::Size measure(std::string_view text, type::Px font_size, type::Weight weight) const override {
+                return type::NaiveFont{}.measure(text, font_size, weight);
+            }
+        };
+
+        Font font;
+        a.expect_eq(font.word_ends("", type::Px{10}, type::Weight::Normal), std::vector{0});
+        a.expect_eq(font.word_ends("a bb  ccc", type::Px{10}, type::Weight::Normal), (std::vector{5, 20, 25, 45}));
+    });
+
     s.add_test("NaiveType::font_cache", [](etest::IActions &a) {
         type::NaiveType type{};
 
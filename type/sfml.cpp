@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2022-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2022-2026 Robin Lindén <dev@robinlinden.eu>
 // SPDX-FileCopyrightText: 2022 Mikael Larsson <c.mikael.larsson@gmail.com>
 //
 // SPDX-License-Identifier: BSD-2-Clause
@@ -89,6 +89,41 @@ Size SfmlFont::measure(std::string_view text, Px font_size, Weight weight) const
     return Size{static_cast<int>(bounds.size.x) + nbsp_extra_width, static_cast<int>(bounds.size.y)};
 }
 
+// Mirrors how sf::Text positions its glyphs, but w/o building any geometry.
+std::vector<int> SfmlFont::word_ends(std::string_view text, Px font_size, Weight weight) const {
+    auto const character_size = static_cast<unsigned>(font_size.v);
+    bool const bold = weight == Weight::Bold;
+    auto const space_advance = font_.getGlyph(U' ', character_size, bold).advance;
+
+    std::vector<int> ends;
+    float x = 0;
+    char32_t previous = 0;
+    for (char32_t const c : sf::String::fromUtf8(text.data(), text.data() + text.size())) {
+        x += font_.getKerning(previous, c, character_size, bold);
+        previous = c;
+
+        switch (c) {
+            case U' ':
+                ends.push_back(static_cast<int>(x));
+                x += space_advance;
+                break;
+            case U'\t':
+                x += space_advance * 4;
+                break;
+            // Same as in measure(), SFML thinks non-breaking spaces have 0 width.
+            case U'\u00A0':
+                x += space_advance;
+                break;
+            default:
+                x += font_.getGlyph(c, character_size, bold).advance;
+                break;
+        }
+    }
+
+    ends.push_back(static_cast<int>(x));
+    return ends;
+}
+
 std::optional<std::shared_ptr<IFont const>> SfmlType::font(std::string_view name) const {
     if (auto font = font_cache_.find(name); font != font_cache_.end()) {
         return font->second;
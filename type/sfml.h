@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: 2023-2025 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2023-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
@@ -16,6 +16,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 namespace type {
 
@@ -24,6 +25,7 @@ public:
     explicit SfmlFont(sf::Font font) : font_{std::move(font)} {}
 
     Size measure(std::string_view text, Px font_size, Weight) const override;
+    std::vector<int> word_ends(std::string_view text, Px font_size, Weight) const override;
 
     sf::Font const &sf_font() const { return font_; }
 
@@ -1,14 +1,16 @@
-// SPDX-FileCopyrightText: 2023-2024 Robin Lindén <dev@robinlinden.eu>
+// SPDX-FileCopyrightText: 2023-2026 Robin Lindén <dev@robinlinden.eu>
 //
 // SPDX-License-Identifier: BSD-2-Clause
 
 #ifndef TYPE_TYPE_H_
 #define TYPE_TYPE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 namespace type {
 
@@ -32,6 +34,28 @@ class IFont {
 public:
     virtual ~IFont() = default;
     [[nodiscard]] virtual Size measure(std::string_view, Px font_size, Weight) const = 0;
+
+    // The advance from the start of `text` to the end of each of its
+    // space-separated words, i.e. how wide `text` is if broken at the space
+    // following that word. By default, the words are measured one by one,
+    // which ignores things like kerning between them.
+    [[nodiscard]] virtual std::vector<int> word_ends(std::string_view text, Px font_size, Weight weight) const {
+        auto const space_width = measure(" ", font_size, weight).width;
+        std::vector<int> ends;
+        int advance = 0;
+        std::size_t word_start = 0;
+        while (true) {
+            auto word_end = text.find(' ', word_start);
+            advance += measure(text.substr(word_start, word_end - word_start), font_size, weight).width;
+            ends.push_back(advance);
+            if (word_end == std::string_view::npos) {
+                return ends;
+            }
+
+            advance += space_width;
+            word_start = word_end + 1;
+        }
+    }
 };
 
 class IType {